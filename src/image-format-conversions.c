@@ -32,24 +32,258 @@
 
 #include "config.h"
 
+#include <math.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "image-format-conversions.h"
 
 /* Basic line-based copy for packed formats */
-void packed_line_copy(int w, int h, int stride, uint8_t *src, uint8_t *dest)
+void packed_line_copy(int w, int h, int bpp, int stride, uint8_t *src, uint8_t *dest)
 {
 	int i;
-	int len = w * 2;
+	int len = w * bpp;
 	for (i = 0; i < h; i++)
 	{
 		memcpy(dest + i * len, src + i * stride, len);
 	}
 }
 
+/* NV12 (Y plane followed by interleaved UV) to UYVY conversion */
+void nv12_to_uyvy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *uv_p, uint8_t *dest)
+{
+	int x, y;
+
+	for (y = 0; y < h; y++)
+	{
+		uint8_t *y_line = y_p + y * y_pitch;
+		/* Each chroma line is shared by two luma lines */
+		uint8_t *uv_line = uv_p + (y >> 1) * uv_pitch;
+
+		for (x = 0; x < w; x += 2)
+		{
+			*dest++ = uv_line[x];
+			*dest++ = y_line[x];
+			*dest++ = uv_line[x + 1];
+			*dest++ = y_line[x + 1];
+		}
+	}
+}
+
+/* Copy of YV12/I420 planes to tightly packed I420 */
+void uv12_copy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest)
+{
+	rect_copy(w, h, y_pitch, w, y_p, dest);
+	dest += w * h;
+	rect_copy(w / 2, h / 2, uv_pitch, w / 2, u_p, dest);
+	dest += (w / 2) * (h / 2);
+	rect_copy(w / 2, h / 2, uv_pitch, w / 2, v_p, dest);
+}
+
+/* log2 of the pixel count in a factor x factor box */
+static int box_shift(int factor)
+{
+	int shift = 0;
+	while ((1 << shift) < factor)
+		shift++;
+	return shift * 2;
+}
+
+/* Box filtered decimation of a packed 4:2:2 format, output is in the same
+ * packing as the input. y_offset tells where the luma is in the
+ * macropixel, 0 for YUY2 and 1 for UYVY.
+ */
+void packed_decimate(int w, int h, int factor, int stride, int y_offset, uint8_t *src, uint8_t *dest)
+{
+	int x, y, i, j;
+	int shift = box_shift(factor);
+	int round = 1 << (shift - 1);
+	int c0 = 1 - y_offset;
+	int c1 = 3 - y_offset;
+
+	for (y = 0; y < h / factor; y++)
+	{
+		uint8_t *line = src + y * factor * stride;
+
+		for (x = 0; x < w / factor; x += 2)
+		{
+			/* The output macropixel covers factor source
+			 * macropixels on factor lines
+			 */
+			unsigned int y0 = 0, y1 = 0, u = 0, v = 0;
+			uint8_t *s = line + x * factor * 2;
+
+			for (j = 0; j < factor; j++)
+			{
+				for (i = 0; i < factor; i++)
+				{
+					y0 += s[i * 2 + y_offset];
+					y1 += s[(factor + i) * 2 + y_offset];
+					u += s[i * 4 + c0];
+					v += s[i * 4 + c1];
+				}
+				s += stride;
+			}
+
+			dest[y_offset] = (y0 + round) >> shift;
+			dest[2 + y_offset] = (y1 + round) >> shift;
+			dest[c0] = (u + round) >> shift;
+			dest[c1] = (v + round) >> shift;
+			dest += 4;
+		}
+	}
+}
+
+/* YV12/I420 to UYVY conversion with box filtered decimation */
+void uv12_to_uyvy_decimate(int w, int h, int factor, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest)
+{
+	int x, y, i, j;
+	int shift = box_shift(factor);
+	int round = 1 << (shift - 1);
+	/* Chroma is half resolution, so a box has half the samples */
+	int c_rows = factor / 2;
+	int c_shift = shift - 1;
+	int c_round = 1 << (c_shift - 1);
+
+	for (y = 0; y < h / factor; y++)
+	{
+		uint8_t *y_line = y_p + y * factor * y_pitch;
+		uint8_t *u_line = u_p + y * c_rows * uv_pitch;
+		uint8_t *v_line = v_p + y * c_rows * uv_pitch;
+
+		for (x = 0; x < w / factor; x += 2)
+		{
+			unsigned int y0 = 0, y1 = 0, u = 0, v = 0;
+			uint8_t *s = y_line + x * factor;
+			uint8_t *su = u_line + x * factor / 2;
+			uint8_t *sv = v_line + x * factor / 2;
+
+			for (j = 0; j < factor; j++)
+			{
+				for (i = 0; i < factor; i++)
+				{
+					y0 += s[i];
+					y1 += s[factor + i];
+				}
+				s += y_pitch;
+			}
+
+			for (j = 0; j < c_rows; j++)
+			{
+				for (i = 0; i < factor; i++)
+				{
+					u += su[i];
+					v += sv[i];
+				}
+				su += uv_pitch;
+				sv += uv_pitch;
+			}
+
+			*dest++ = (u + c_round) >> c_shift;
+			*dest++ = (y0 + round) >> shift;
+			*dest++ = (v + c_round) >> c_shift;
+			*dest++ = (y1 + round) >> shift;
+		}
+	}
+}
+
+void csc_matrix_init(struct csc_matrix *m, int bt709, int brightness,
+                     int contrast, int saturation, int hue)
+{
+	/* Luma weights of red and blue */
+	double kr = bt709 ? 0.2126 : 0.299;
+	double kb = bt709 ? 0.0722 : 0.114;
+	double kg = 1.0 - kr - kb;
+	/* Limited range Y and UV to full range RGB, with the contrast and
+	 * saturation on top
+	 */
+	double ys = 255.0 / 219.0 * (contrast + 1000) / 1000.0;
+	double cs = 255.0 / 224.0 * (contrast + 1000) / 1000.0
+	            * (saturation + 1000) / 1000.0;
+	double h = hue * M_PI / 1000.0;
+	/* How much U and V go to each of R, G and B */
+	double cu[3] = { 0.0, -2.0 * kb * (1.0 - kb) / kg, 2.0 * (1.0 - kb) };
+	double cv[3] = { 2.0 * (1.0 - kr), -2.0 * kr * (1.0 - kr) / kg, 0.0 };
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		/* The hue turns the UV plane */
+		double u = cs * (cu[i] * cos(h) + cv[i] * sin(h));
+		double v = cs * (cv[i] * cos(h) - cu[i] * sin(h));
+
+		m->m[i][0] = lrint(ys * 4096.0);
+		m->m[i][1] = lrint(u * 4096.0);
+		m->m[i][2] = lrint(v * 4096.0);
+
+		/* Take the Y and UV biases out, add the brightness and round */
+		m->offset[i] = -16 * m->m[i][0] - 128 * (m->m[i][1] + m->m[i][2])
+		               + brightness * 128 * 4096 / 1000 + 2048;
+	}
+}
+
+static inline int clamp_u8(int v)
+{
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/* Linear interpolation at a 16.16 fixed point position between samples
+ * inc bytes apart, last being the index of the last sample
+ */
+static inline int sample_lerp(const uint8_t *p, int inc, int pos, int last)
+{
+	int i, f;
+
+	if (pos <= 0)
+		return p[0];
+	i = pos >> 16;
+	if (i >= last)
+		return p[last * inc];
+	f = (pos >> 8) & 0xff;
+	return (p[i * inc] * (256 - f) + p[(i + 1) * inc] * f) >> 8;
+}
+
+/* One pixel of yuv_scale_line_to_rgb, at source position x */
+static inline void yuv_scale_pixel_to_rgb(int x, int src_w,
+                                          const uint8_t *y_p, int y_inc,
+                                          const uint8_t *u_p, const uint8_t *v_p,
+                                          int uv_inc, const struct csc_matrix *csc,
+                                          int bpp, uint8_t *dest)
+{
+	/* Chroma samples sit between each pair of luma ones */
+	int c = (x >> 1) - 16384;
+	int c_last = (src_w + 1) / 2 - 1;
+	int y = sample_lerp(y_p, y_inc, x, src_w - 1);
+	int u = sample_lerp(u_p, uv_inc, c, c_last);
+	int v = sample_lerp(v_p, uv_inc, c, c_last);
+	int r, g, b;
+
+	r = clamp_u8((csc->m[0][0] * y + csc->m[0][1] * u
+	              + csc->m[0][2] * v + csc->offset[0]) >> 12);
+	g = clamp_u8((csc->m[1][0] * y + csc->m[1][1] * u
+	              + csc->m[1][2] * v + csc->offset[1]) >> 12);
+	b = clamp_u8((csc->m[2][0] * y + csc->m[2][1] * u
+	              + csc->m[2][2] * v + csc->offset[2]) >> 12);
+
+	if (bpp == 2)
+		*(uint16_t *)dest = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+	else
+		*(uint32_t *)dest = (r << 16) | (g << 8) | b;
+}
+
 #ifndef HAVE_NEON
 
+void rect_copy(int len, int h, int src_stride, int dest_stride, uint8_t *src, uint8_t *dest)
+{
+	int i;
+	for (i = 0; i < h; i++)
+	{
+		memcpy(dest, src, len);
+		src += src_stride;
+		dest += dest_stride;
+	}
+}
+
 /* Basic C implementation of YV12/I420 to UYVY conversion */
 void uv12_to_uyvy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest)
 {
@@ -95,10 +329,100 @@ void uv12_to_uyvy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t
 	}
 }
 
+/* YV12/I420 to the YUV420 format of the Epson S1D13745 (Blizzard). It is
+ * packed and line-interleaved with 12 bits per pixel: every 4 pixels of
+ * a line are [C0 Y0 Y1 C1 Y2 Y3], where the chroma is U on even lines and
+ * V on odd lines. The bus to the controller is 16 bits wide and the bytes
+ * of each halfword go the other way around, so in memory it becomes
+ * [Y0 C0 C1 Y1 Y3 Y2].
+ */
+void uv12_to_blizzard_yuv420(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest)
+{
+	int x, y;
+
+	for (y = 0; y < h; y++)
+	{
+		uint8_t *y_line = y_p + y * y_pitch;
+		uint8_t *c_line = ((y & 1) ? v_p : u_p) + (y >> 1) * uv_pitch;
+
+		for (x = 0; x < w; x += 4)
+		{
+			*dest++ = y_line[0];
+			*dest++ = c_line[0];
+			*dest++ = c_line[1];
+			*dest++ = y_line[1];
+			*dest++ = y_line[3];
+			*dest++ = y_line[2];
+			y_line += 4;
+			c_line += 2;
+		}
+	}
+}
+
+void line_blend(int len, int frac, uint8_t *a, uint8_t *b, uint8_t *dest)
+{
+	int i;
+
+	if (frac == 0) {
+		memcpy(dest, a, len);
+		return;
+	}
+
+	for (i = 0; i < len; i++)
+		dest[i] = (a[i] * (256 - frac) + b[i] * frac) >> 8;
+}
+
+void yuv_scale_line_to_rgb(int w, int x, int step, int src_w,
+                           const uint8_t *y_p, int y_inc,
+                           const uint8_t *u_p, const uint8_t *v_p, int uv_inc,
+                           const struct csc_matrix *csc, int bpp, uint8_t *dest)
+{
+	int i;
+
+	for (i = 0; i < w; i++, x += step, dest += bpp)
+		yuv_scale_pixel_to_rgb(x, src_w, y_p, y_inc, u_p, v_p, uv_inc,
+		                       csc, bpp, dest);
+}
+
 #endif /* ! HAVE_NEON */
 
 #ifdef HAVE_NEON
 
+void rect_copy(int len, int h, int src_stride, int dest_stride, uint8_t *src, uint8_t *dest)
+{
+    int i;
+    for (i = 0; i < h; i++)
+    {
+        uint8_t *s = src;
+        uint8_t *d = dest;
+        int n = len & ~63;
+
+        if (n)
+        {
+            // whole 64-byte bursts, which is what the write-combining
+            // buffer of the scanout memory likes best
+            asm volatile (
+                    "1:\n\t"
+                    "pld       [%[s], #192]\n\t"
+                    "vld1.u8   {d0-d3}, [%[s]]!\n\t"
+                    "vld1.u8   {d4-d7}, [%[s]]!\n\t"
+                    "subs      %[n],%[n],#64\n\t"
+                    "vst1.u8   {d0-d3}, [%[d]]!\n\t"
+                    "vst1.u8   {d4-d7}, [%[d]]!\n\t"
+                    "bgt       1b\n\t"
+                    : [s] "+r" (s), [d] "+r" (d), [n] "+r" (n)
+                    :
+                    : "cc", "memory", "d0","d1","d2","d3","d4","d5","d6","d7"
+                    );
+        }
+        if (len & 63)
+            memcpy(d, s, len & 63);
+
+        src += src_stride;
+        dest += dest_stride;
+    }
+}
+
 void uv12_to_uyvy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest)
 {
     int x, y;
@@ -199,4 +523,235 @@ void uv12_to_uyvy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t
     }
 }
 
+void uv12_to_blizzard_yuv420(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest)
+{
+    int x, y;
+
+    for (y = 0; y < h; y++)
+    {
+        uint8_t *y_line = y_p + y * y_pitch;
+        uint8_t *c_line = ((y & 1) ? v_p : u_p) + (y >> 1) * uv_pitch;
+        int n = w & ~31;
+
+        if (n)
+        {
+            // 32 pixels at a time: split the luma by position in the
+            // 4-pixel group and the chroma by even/odd, pair them up
+            // into the three halfwords of a group and store those
+            // interleaved
+            asm volatile (
+                    "1:\n\t"
+                    "vld4.u8   {d0-d3}, [%[y_line]]!\n\t"
+                    "vld2.u8   {d4,d5}, [%[c_line]]!\n\t"
+                    "subs      %[n],%[n],#32\n\t"
+                    "vmov      d20, d0\n\t"
+                    "vmov      d21, d4\n\t"
+                    "vzip.u8   d20, d21\n\t"
+                    "vmov      d22, d5\n\t"
+                    "vmov      d23, d1\n\t"
+                    "vzip.u8   d22, d23\n\t"
+                    "vmov      d24, d3\n\t"
+                    "vmov      d25, d2\n\t"
+                    "vzip.u8   d24, d25\n\t"
+                    "vst3.u16  {d20,d22,d24}, [%[dest]]!\n\t"
+                    "vst3.u16  {d21,d23,d25}, [%[dest]]!\n\t"
+                    "bgt       1b\n\t"
+                    : [y_line] "+r" (y_line), [c_line] "+r" (c_line), [dest] "+r" (dest), [n] "+r" (n)
+                    :
+                    : "cc", "memory", "d0","d1","d2","d3","d4","d5",
+                      "d20","d21","d22","d23","d24","d25"
+                    );
+        }
+
+        for (x = w & ~31; x < w; x += 4)
+        {
+            *dest++ = y_line[0];
+            *dest++ = c_line[0];
+            *dest++ = c_line[1];
+            *dest++ = y_line[1];
+            *dest++ = y_line[3];
+            *dest++ = y_line[2];
+            y_line += 4;
+            c_line += 2;
+        }
+    }
+}
+
+void line_blend(int len, int frac, uint8_t *a, uint8_t *b, uint8_t *dest)
+{
+    int n = len & ~15;
+
+    if (frac == 0)
+    {
+        memcpy(dest, a, len);
+        return;
+    }
+
+    if (n)
+    {
+        // 16 bytes at a time, widened to 16 bits for the weighting
+        asm volatile (
+                "vdup.u8   d28, %[fa]\n\t"
+                "vdup.u8   d29, %[fb]\n\t"
+                "1:\n\t"
+                "pld       [%[a], #64]\n\t"
+                "pld       [%[b], #64]\n\t"
+                "vld1.u8   {d0-d1}, [%[a]]!\n\t"
+                "vld1.u8   {d2-d3}, [%[b]]!\n\t"
+                "vmull.u8  q2, d0, d28\n\t"
+                "vmull.u8  q3, d1, d28\n\t"
+                "vmlal.u8  q2, d2, d29\n\t"
+                "vmlal.u8  q3, d3, d29\n\t"
+                "vshrn.u16 d0, q2, #8\n\t"
+                "vshrn.u16 d1, q3, #8\n\t"
+                "subs      %[n],%[n],#16\n\t"
+                "vst1.u8   {d0-d1}, [%[d]]!\n\t"
+                "bgt       1b\n\t"
+                : [a] "+r" (a), [b] "+r" (b), [d] "+r" (dest), [n] "+r" (n)
+                : [fa] "r" (256 - frac), [fb] "r" (frac)
+                : "cc", "memory", "d0","d1","d2","d3","d4","d5","d6","d7","d28","d29"
+                );
+    }
+
+    for (n = 0; n < (len & 15); n++)
+        dest[n] = (a[n] * (256 - frac) + b[n] * frac) >> 8;
+}
+
+/* The two samples around a 16.16 position and the weight of the second,
+ * clamped at the ends like sample_lerp does
+ */
+static inline void sample_taps(const uint8_t *p, int inc, int pos, int last,
+                               uint8_t *a, uint8_t *b, uint8_t *f)
+{
+    int i = pos >> 16;
+
+    if (pos <= 0 || i >= last)
+    {
+        *a = *b = p[pos <= 0 ? 0 : last * inc];
+        *f = 0;
+        return;
+    }
+
+    *a = p[i * inc];
+    *b = p[(i + 1) * inc];
+    *f = (pos >> 8) & 0xff;
+}
+
+void yuv_scale_line_to_rgb(int w, int x, int step, int src_w,
+                           const uint8_t *y_p, int y_inc,
+                           const uint8_t *u_p, const uint8_t *v_p, int uv_inc,
+                           const struct csc_matrix *csc, int bpp, uint8_t *dest)
+{
+    struct {
+        uint8_t ya[8], yb[8], yf[8];
+        uint8_t ua[8], ub[8], va[8], vb[8], cf[8];
+    } t;
+    int last = src_w - 1;
+    int c_last = (src_w + 1) / 2 - 1;
+    int i, j;
+
+    for (i = 0; i + 8 <= w; i += 8)
+    {
+        const int *m = &csc->m[0][0];
+        uint8_t *taps = t.ya;
+
+        // NEON can't gather, so pick the samples around each of the
+        // 8 pixels here
+        for (j = 0; j < 8; j++, x += step)
+        {
+            int c = (x >> 1) - 16384;
+            sample_taps(y_p, y_inc, x, last, &t.ya[j], &t.yb[j], &t.yf[j]);
+            sample_taps(u_p, uv_inc, c, c_last, &t.ua[j], &t.ub[j], &t.cf[j]);
+            sample_taps(v_p, uv_inc, c, c_last, &t.va[j], &t.vb[j], &t.cf[j]);
+        }
+
+        // Weight the samples as a * (256 - f) + b * f in 16 bits, take
+        // Y, U and V to 32 bits and run them through the matrix (the
+        // coefficients don't fit 16 bits), then saturate down to 8 bit
+        // R, G and B and store those as XRGB8888 or RGB565
+        asm volatile (
+                "vld1.32     {d0-d3}, [%[m]]!\n\t"
+                "vld1.32     {d4-d5}, [%[m]]\n\t"
+                "vld1.u8     {d16-d19}, [%[t]]!\n\t"
+                "vld1.u8     {d20-d23}, [%[t]]\n\t"
+                "vshll.u8    q12, d16, #8\n\t"
+                "vmlsl.u8    q12, d16, d18\n\t"
+                "vmlal.u8    q12, d17, d18\n\t"
+                "vshll.u8    q13, d19, #8\n\t"
+                "vmlsl.u8    q13, d19, d23\n\t"
+                "vmlal.u8    q13, d20, d23\n\t"
+                "vshll.u8    q14, d21, #8\n\t"
+                "vmlsl.u8    q14, d21, d23\n\t"
+                "vmlal.u8    q14, d22, d23\n\t"
+                "vshr.u16    q12, q12, #8\n\t"
+                "vshr.u16    q13, q13, #8\n\t"
+                "vshr.u16    q14, q14, #8\n\t"
+                "vmovl.u16   q8, d24\n\t"
+                "vmovl.u16   q9, d25\n\t"
+                "vmovl.u16   q10, d26\n\t"
+                "vmovl.u16   q11, d27\n\t"
+                "vmovl.u16   q12, d28\n\t"
+                "vmovl.u16   q13, d29\n\t"
+                // R
+                "vdup.32     q4, d4[1]\n\t"
+                "vmov        q5, q4\n\t"
+                "vmla.i32    q4, q8, d0[0]\n\t"
+                "vmla.i32    q5, q9, d0[0]\n\t"
+                "vmla.i32    q4, q10, d0[1]\n\t"
+                "vmla.i32    q5, q11, d0[1]\n\t"
+                "vmla.i32    q4, q12, d1[0]\n\t"
+                "vmla.i32    q5, q13, d1[0]\n\t"
+                "vqshrun.s32 d28, q4, #12\n\t"
+                "vqshrun.s32 d29, q5, #12\n\t"
+                // G
+                "vdup.32     q4, d5[0]\n\t"
+                "vmov        q5, q4\n\t"
+                "vmla.i32    q4, q8, d1[1]\n\t"
+                "vmla.i32    q5, q9, d1[1]\n\t"
+                "vmla.i32    q4, q10, d2[0]\n\t"
+                "vmla.i32    q5, q11, d2[0]\n\t"
+                "vmla.i32    q4, q12, d2[1]\n\t"
+                "vmla.i32    q5, q13, d2[1]\n\t"
+                "vqshrun.s32 d30, q4, #12\n\t"
+                "vqshrun.s32 d31, q5, #12\n\t"
+                // B
+                "vdup.32     q4, d5[1]\n\t"
+                "vmov        q5, q4\n\t"
+                "vmla.i32    q4, q8, d3[0]\n\t"
+                "vmla.i32    q5, q9, d3[0]\n\t"
+                "vmla.i32    q4, q10, d3[1]\n\t"
+                "vmla.i32    q5, q11, d3[1]\n\t"
+                "vmla.i32    q4, q12, d4[0]\n\t"
+                "vmla.i32    q5, q13, d4[0]\n\t"
+                "vqshrun.s32 d6, q4, #12\n\t"
+                "vqshrun.s32 d7, q5, #12\n\t"
+                "vqmovn.u16  d8, q3\n\t"
+                "vqmovn.u16  d9, q15\n\t"
+                "vqmovn.u16  d10, q14\n\t"
+                "cmp         %[bpp], #2\n\t"
+                "beq         1f\n\t"
+                "vmov.i8     d11, #0\n\t"
+                "vst4.u8     {d8-d11}, [%[d]]!\n\t"
+                "b           2f\n\t"
+                "1:\n\t"
+                "vshll.u8    q12, d10, #8\n\t"
+                "vshll.u8    q13, d9, #8\n\t"
+                "vshll.u8    q14, d8, #8\n\t"
+                "vsri.16     q12, q13, #5\n\t"
+                "vsri.16     q12, q14, #11\n\t"
+                "vst1.16     {d24-d25}, [%[d]]!\n\t"
+                "2:\n\t"
+                : [m] "+r" (m), [t] "+r" (taps), [d] "+r" (dest)
+                : [bpp] "r" (bpp)
+                : "cc", "memory", "d0","d1","d2","d3","d4","d5","d6","d7",
+                  "d8","d9","d10","d11","d16","d17","d18","d19","d20","d21",
+                  "d22","d23","d24","d25","d26","d27","d28","d29","d30","d31"
+                );
+    }
+
+    for (; i < w; i++, x += step, dest += bpp)
+        yuv_scale_pixel_to_rgb(x, src_w, y_p, y_inc, u_p, v_p, uv_inc,
+                               csc, bpp, dest);
+}
+
 #endif /* HAVE_NEON */
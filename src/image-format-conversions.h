@@ -26,8 +26,65 @@
 
 #include <stdint.h>
 
-/* Basic line-based copy for packed formats */
-void packed_line_copy(int w, int h, int stride, uint8_t *src, uint8_t *dest);
+/* Basic line-based copy for packed formats, bpp is in bytes */
+void packed_line_copy(int w, int h, int bpp, int stride, uint8_t *src, uint8_t *dest);
+
+/* Copies a rectangle of len bytes wide lines, suited for writing to
+ * uncached/write-combined memory
+ */
+void rect_copy(int len, int h, int src_stride, int dest_stride, uint8_t *src, uint8_t *dest);
+
+/* NV12 to UYVY conversion */
+void nv12_to_uyvy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *uv_p, uint8_t *dest);
+
+/* YV12/I420 to the native YUV420 format of the Blizzard LCD controller,
+ * 12 bits per pixel. w must be a multiple of 4.
+ */
+void uv12_to_blizzard_yuv420(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest);
+
+/* Copies the planes of YV12/I420 to tightly packed I420 (Y, U, V) */
+void uv12_copy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest);
+
+/* Shrinks packed 4:2:2 images by factor (a power of two) in both
+ * directions with a box filter. w and h are the source size, multiples of
+ * 2 * factor. y_offset is 0 for YUY2 and 1 for UYVY.
+ */
+void packed_decimate(int w, int h, int factor, int stride, int y_offset, uint8_t *src, uint8_t *dest);
+
+/* YV12/I420 to UYVY conversion that shrinks the image by factor (a power
+ * of two) with a box filter on the way, w and h are the source size
+ */
+void uv12_to_uyvy_decimate(int w, int h, int factor, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest);
+
+/* Blends two lines of len bytes, frac/256 of the way from a to b. Used
+ * for vertical bilinear scaling, before or after it doesn't matter what
+ * the bytes are.
+ */
+void line_blend(int len, int frac, uint8_t *a, uint8_t *b, uint8_t *dest);
+
+/* YUV to RGB conversion matrix in 1/4096ths, rgb = m * yuv + offset */
+struct csc_matrix {
+	int m[3][3];
+	int offset[3];
+};
+
+/* BT.601 or BT.709 limited range YUV to full range RGB. The controls go
+ * from -1000 to 1000 with 0 for no change, the hue from -180 to 180
+ * degrees.
+ */
+void csc_matrix_init(struct csc_matrix *m, int bt709, int brightness,
+                     int contrast, int saturation, int hue);
+
+/* Scales a line of YUV horizontally with bilinear filtering and converts
+ * it to RGB565 (bpp 2) or XRGB8888 (bpp 4). x is the source position of
+ * the first of the w destination pixels and step the distance between
+ * them, in 16.16 fixed point, src_w the number of luma samples. Samples
+ * are y_inc and uv_inc bytes apart, so both planar and packed lines work.
+ */
+void yuv_scale_line_to_rgb(int w, int x, int step, int src_w,
+                           const uint8_t *y_p, int y_inc,
+                           const uint8_t *u_p, const uint8_t *v_p, int uv_inc,
+                           const struct csc_matrix *csc, int bpp, uint8_t *dest);
 
 /* Basic C implementation of YV12/I420 to UYVY conversion */
 void uv12_to_uyvy(int w, int h, int y_pitch, int uv_pitch, uint8_t *y_p, uint8_t *u_p, uint8_t *v_p, uint8_t *dest);
@@ -0,0 +1,86 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "omapfb-bandwidth.h"
+
+void
+bw_budget_init(struct bw_budget *b, unsigned long limit)
+{
+	memset(b, 0, sizeof(*b));
+	b->limit = limit;
+}
+
+unsigned long
+bw_plane_cost(const struct bw_plane *p)
+{
+	unsigned long long bytes;
+
+	if (p->src_width <= 0 || p->src_height <= 0
+	 || p->out_height <= 0 || p->htotal <= 0 || p->pixel_clock <= 0)
+		return 0;
+
+	/* One output line takes htotal pixel clocks, during which
+	 * src_height / out_height source lines get fetched. The clock is
+	 * in kHz, which gives kB/s directly.
+	 */
+	bytes = (unsigned long long)p->src_width * p->bits_per_pixel / 8;
+	bytes = bytes * p->src_height * p->pixel_clock;
+
+	return bytes / ((unsigned long long)p->out_height * p->htotal);
+}
+
+unsigned long
+bw_total(const struct bw_budget *b)
+{
+	unsigned long total = 0;
+	int i;
+
+	for (i = 0; i < BW_MAX_CONSUMERS; i++)
+		total += b->cost[i];
+
+	return total;
+}
+
+int
+bw_fits(const struct bw_budget *b, int consumer, unsigned long cost)
+{
+	unsigned long others = 0;
+
+	if (b->limit == 0)
+		return 1;
+
+	if (consumer >= 0 && consumer < BW_MAX_CONSUMERS)
+		others = bw_total(b) - b->cost[consumer];
+
+	return others + cost <= b->limit;
+}
+
+void
+bw_set(struct bw_budget *b, int consumer, unsigned long cost)
+{
+	if (consumer >= 0 && consumer < BW_MAX_CONSUMERS)
+		b->cost[consumer] = cost;
+}
@@ -0,0 +1,74 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * Accounting of the memory bandwidth the display controller needs for
+ * scanning out its planes, so that configurations that would make the
+ * FIFOs underflow can be turned down before they are tried.
+ *
+ * This is plain C without X server dependencies, so that it can be built
+ * and exercised on its own.
+ */
+
+#ifndef __OMAPFB_BANDWIDTH_H__
+#define __OMAPFB_BANDWIDTH_H__
+
+#define BW_MAX_CONSUMERS 16
+
+struct bw_plane {
+	/* What is fetched from memory */
+	int src_width, src_height;
+	int bits_per_pixel;
+	/* What it covers on the display */
+	int out_width, out_height;
+	/* Timings of the display it is on, clock in kHz */
+	int pixel_clock;
+	int htotal, vtotal;
+};
+
+struct bw_budget {
+	/* kB/s, 0 if there is no limit */
+	unsigned long limit;
+	/* What each consumer (plane) uses now */
+	unsigned long cost[BW_MAX_CONSUMERS];
+};
+
+void bw_budget_init(struct bw_budget *b, unsigned long limit);
+
+/* Peak fetch rate of the plane in kB/s. Vertical downscaling makes the
+ * plane fetch several lines per output line, which is what counts.
+ */
+unsigned long bw_plane_cost(const struct bw_plane *p);
+
+/* Sum of what all consumers use */
+unsigned long bw_total(const struct bw_budget *b);
+
+/* Would the consumer fit in the budget with the given cost, next to
+ * what the others use? consumer may be -1 to check the cost on its own.
+ */
+int bw_fits(const struct bw_budget *b, int consumer, unsigned long cost);
+
+void bw_set(struct bw_budget *b, int consumer, unsigned long cost);
+
+#endif /* __OMAPFB_BANDWIDTH_H__ */
@@ -21,27 +21,129 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include "xorg-server.h"
 
 #include "xf86Crtc.h"
 
+#ifdef HAVE_XEXTPROTO_71
+#include <X11/extensions/dpmsconst.h>
+#else
+#define DPMS_SERVER
+#include <X11/extensions/dpms.h>
+#endif
+
 #include "omapfb-driver.h"
 #include "omapfb-crtc.h"
+#include "omapfb-cursor.h"
+#include "omapfb-damage.h"
+#include "omapfb-utils.h"
+
+/* Limits of the DSS video overlay scaler */
+#define OMAPFB_MAX_UPSCALE 8
+#define OMAPFB_MAX_DOWNSCALE 2
+
+/* Updates the virtual resolution of the base framebuffer, which holds the
+ * memory for all CRTCs
+ */
+Bool
+OMAPFBSetVirtualSize (ScrnInfoPtr pScrn, int width, int height)
+{
+	struct fb_var_screeninfo v;
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	/* With page flipping, the pages are stacked vertically */
+	height *= ofb->pages;
+
+	if (width == ofb->state_info.xres_virtual
+	 && height == ofb->state_info.yres_virtual)
+		return TRUE;
+
+	if (width * height * (ofb->state_info.bits_per_pixel >> 3)
+	    > ofb->mem_info.size) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: %ix%i does not fit in framebuffer memory\n",
+		           __FUNCTION__, width, height);
+		return FALSE;
+	}
+
+	v = ofb->state_info;
+	v.xres_virtual = width;
+	v.yres_virtual = height;
+	if (v.xres > width)
+		v.xres = width;
+	if (v.yres > height)
+		v.yres = height;
+	v.xoffset = 0;
+	v.yoffset = 0;
+	v.activate = FB_ACTIVATE_NOW;
+
+	/* The base CRTC mode set can't be skipped after this */
+	if (ofb->num_crtcs > 0) {
+		OMAPFBCrtcPtr base = ofb->crtcs[0]->driver_private;
+		base->committed_valid = FALSE;
+		base->plane_valid = FALSE;
+	}
+
+	if (ioctl (ofb->fd, FBIOPUT_VSCREENINFO, &v)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Setting virtual resolution failed: %s\n",
+		           __FUNCTION__, strerror(errno));
+		return FALSE;
+	}
+
+	if (ioctl (ofb->fd, FBIOGET_VSCREENINFO, &ofb->state_info)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Reading resolution info failed: %s\n",
+		           __FUNCTION__, strerror(errno));
+	}
+
+	if (ioctl (ofb->fd, FBIOGET_FSCREENINFO, &ofb->fixed_info)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Reading hardware info failed: %s\n",
+		           __FUNCTION__, strerror(errno));
+	}
+
+	/* Update stride */
+	pScrn->displayWidth = ofb->fixed_info.line_length /
+	                      (ofb->state_info.bits_per_pixel >> 3);
+
+	return TRUE;
+}
 
 static Bool
 OMAPFBCrtcResize (ScrnInfoPtr pScrn, int width, int height)
 {
 	OMAPFBPtr ofb = OMAPFB(pScrn);
+	ScreenPtr pScreen = screenInfo.screens[pScrn->scrnIndex];
 
 	if (width == pScrn->virtualX && height == pScrn->virtualY)
 		return TRUE;
 
-	/* We never change the actual size of the fb, so we just update
-	 * the required values here. The mode is actually applied in SetMode.
+	/* The memory is allocated by the kernel, so we only change the
+	 * virtual resolution of the base framebuffer. The CRTCs look at
+	 * their part of it in SetMode.
 	 */
+	if (!OMAPFBSetVirtualSize(pScrn, width, height))
+		return FALSE;
+
 	pScrn->virtualX = width;
 	pScrn->virtualY = height;
 
+	if (!OMAPFBDamageAllocate(pScrn))
+		return FALSE;
+
+	/* Stride might have changed, let the screen pixmap know */
+	if (pScreen != NULL && pScreen->GetScreenPixmap != NULL) {
+		PixmapPtr pixmap = pScreen->GetScreenPixmap(pScreen);
+		pScreen->ModifyPixmapHeader(pixmap, width, height, -1, -1,
+		                            ofb->fixed_info.line_length,
+		                            OMAPFBDamageRenderBuffer(pScrn));
+	}
+
 	return TRUE;
 }
 
@@ -49,9 +151,271 @@ static xf86CrtcConfigFuncsRec OMAPFBCrtcConfigFuncs = {
 	OMAPFBCrtcResize /* Resize */
 };
 
+/* fbdev rotation for a RandR one. RandR rotates counter-clockwise. */
+static int
+OMAPFBCrtcFBRotation (Rotation rotation)
+{
+	switch (rotation & 0xf) {
+		case RR_Rotate_90:
+			return FB_ROTATE_CCW;
+		case RR_Rotate_180:
+			return FB_ROTATE_UD;
+		case RR_Rotate_270:
+			return FB_ROTATE_CW;
+		case RR_Rotate_0:
+		default:
+			return FB_ROTATE_UR;
+	}
+}
+
+/* Scale factors of the CRTC transform (framebuffer pixels per display
+ * pixel). Returns FALSE if the transform is more than a scale.
+ */
+static Bool
+OMAPFBCrtcGetScale (xf86CrtcPtr crtc, double *sx, double *sy)
+{
+	*sx = 1.0;
+	*sy = 1.0;
+
+	if (!crtc->transformPresent)
+		return TRUE;
+
+	if (crtc->transform.f_transform.m[0][1] != 0.0
+	 || crtc->transform.f_transform.m[0][2] != 0.0
+	 || crtc->transform.f_transform.m[1][0] != 0.0
+	 || crtc->transform.f_transform.m[1][2] != 0.0
+	 || crtc->transform.f_transform.m[2][0] != 0.0
+	 || crtc->transform.f_transform.m[2][1] != 0.0
+	 || crtc->transform.f_transform.m[2][2] != 1.0)
+		return FALSE;
+
+	*sx = crtc->transform.f_transform.m[0][0];
+	*sy = crtc->transform.f_transform.m[1][1];
+
+	return *sx > 0.0 && *sy > 0.0;
+}
+
+Bool
+OMAPFBCrtcScaled (xf86CrtcPtr crtc)
+{
+	double sx, sy;
+
+	return OMAPFBCrtcGetScale(crtc, &sx, &sy) && (sx != 1.0 || sy != 1.0);
+}
+
+/* Size of the part of the framebuffer the CRTC shows */
+static void
+OMAPFBCrtcFramebufferSize (xf86CrtcPtr crtc, int *width, int *height)
+{
+	double sx, sy;
+	int w = crtc->mode.HDisplay;
+	int h = crtc->mode.VDisplay;
+
+	/* Rotation comes first, then the scaling */
+	if (crtc->rotation & (RR_Rotate_90 | RR_Rotate_270)) {
+		w = crtc->mode.VDisplay;
+		h = crtc->mode.HDisplay;
+	}
+
+	OMAPFBCrtcGetScale(crtc, &sx, &sy);
+	*width = (int)(w * sx + 0.5);
+	*height = (int)(h * sy + 0.5);
+}
+
+/* Would setting b be the same mode set as a, ignoring the panning? */
+static Bool
+OMAPFBCrtcSameMode (struct fb_var_screeninfo *a, struct fb_var_screeninfo *b)
+{
+	return a->xres == b->xres
+	    && a->yres == b->yres
+	    && a->xres_virtual == b->xres_virtual
+	    && a->yres_virtual == b->yres_virtual
+	    && a->bits_per_pixel == b->bits_per_pixel
+	    && a->nonstd == b->nonstd
+	    && a->rotate == b->rotate
+	    && a->pixclock == b->pixclock
+	    && a->left_margin == b->left_margin
+	    && a->right_margin == b->right_margin
+	    && a->upper_margin == b->upper_margin
+	    && a->lower_margin == b->lower_margin
+	    && a->hsync_len == b->hsync_len
+	    && a->vsync_len == b->vsync_len;
+}
+
+unsigned long
+OMAPFBCrtcPlaneBandwidth (xf86CrtcPtr crtc,
+                          int src_w, int src_h, int bpp,
+                          int out_w, int out_h)
+{
+	struct bw_plane p;
+
+	p.src_width = src_w;
+	p.src_height = src_h;
+	p.bits_per_pixel = bpp;
+	p.out_width = out_w;
+	p.out_height = out_h;
+	p.pixel_clock = crtc->mode.Clock;
+	p.htotal = crtc->mode.HTotal;
+	p.vtotal = crtc->mode.VTotal;
+
+	return bw_plane_cost(&p);
+}
+
+/* Bandwidth of the CRTC's own framebuffer plane */
+static unsigned long
+OMAPFBCrtcBandwidth (xf86CrtcPtr crtc)
+{
+	int width, height;
+
+	OMAPFBCrtcFramebufferSize(crtc, &width, &height);
+
+	/* Rotation doesn't change how much is fetched per display line */
+	if (crtc->rotation & (RR_Rotate_90 | RR_Rotate_270)) {
+		int tmp = width;
+		width = height;
+		height = tmp;
+	}
+
+	return OMAPFBCrtcPlaneBandwidth(crtc, width, height,
+	                                OMAPFB(crtc->scrn)->state_info.bits_per_pixel,
+	                                crtc->mode.HDisplay, crtc->mode.VDisplay);
+}
+
+static int
+OMAPFBCrtcIndex (xf86CrtcPtr crtc)
+{
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+	int i;
+
+	for (i = 0; i < ofb->num_crtcs; i++)
+		if (ofb->crtcs[i] == crtc)
+			return i;
+
+	return -1;
+}
+
+/* Is this the CRTC scanning out the base framebuffer? */
+static Bool
+OMAPFBCrtcIsBase (xf86CrtcPtr crtc)
+{
+	return crtc == OMAPFB(crtc->scrn)->crtcs[0];
+}
+
+static Bool
+OMAPFBCrtcOpen (xf86CrtcPtr crtc)
+{
+	char fb_path[PATH_MAX];
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+
+	if (ocrtc->fd != -1)
+		return TRUE;
+
+	snprintf(fb_path, PATH_MAX, "/dev/fb%i", ocrtc->fb_idx);
+	ocrtc->fd = open(fb_path, O_RDWR, 0);
+	if (ocrtc->fd == -1) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
+		           "%s: Opening '%s' failed: %s\n", __FUNCTION__,
+		           fb_path, strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Secondary CRTCs scan out parts of the base framebuffer, so they
+ * don't need memory of their own
+ */
+static void
+OMAPFBCrtcReleaseMemory (xf86CrtcPtr crtc)
+{
+	struct omapfb_mem_info mem_info;
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+
+	if (ioctl (ocrtc->fd, OMAPFB_QUERY_MEM, &mem_info) || mem_info.size == 0)
+		return;
+
+	mem_info.size = 0;
+	if (ioctl (ocrtc->fd, OMAPFB_SETUP_MEM, &mem_info)) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_WARNING,
+		           "%s: Releasing memory of fb%i failed: %s\n",
+		           __FUNCTION__, ocrtc->fb_idx, strerror(errno));
+	}
+}
+
+/* Makes the overlays of the CRTC cover the display. Secondary CRTCs are
+ * also pointed to the base framebuffer memory.
+ */
+static Bool
+OMAPFBCrtcSetupPlane (xf86CrtcPtr crtc)
+{
+	struct omapfb_plane_info plane_info;
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+	OMAPFBCrtcPtr base = OMAPFB(crtc->scrn)->crtcs[0]->driver_private;
+	int mem_idx;
+
+	if (OMAPFBCrtcIsBase(crtc))
+		mem_idx = 0;
+	else
+		mem_idx = OMAPFB_MEM_IDX_ENABLED
+		          | (base->fb_idx & OMAPFB_MEM_IDX_MASK);
+
+	/* We set it up like this the last time */
+	if (ocrtc->plane_valid
+	 && ocrtc->plane.out_width == crtc->mode.HDisplay
+	 && ocrtc->plane.out_height == crtc->mode.VDisplay
+	 && ocrtc->plane.mem_idx == mem_idx)
+		return TRUE;
+
+	if (ioctl (ocrtc->fd, OMAPFB_QUERY_PLANE, &plane_info)) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
+		           "%s: Reading plane info failed: %s\n",
+		           __FUNCTION__, strerror(errno));
+		return FALSE;
+	}
+
+	/* Nothing to do if the overlay is already set up like this */
+	if (plane_info.enabled
+	 && plane_info.pos_x == 0 && plane_info.pos_y == 0
+	 && plane_info.out_width == crtc->mode.HDisplay
+	 && plane_info.out_height == crtc->mode.VDisplay
+	 && plane_info.mem_idx == mem_idx) {
+		ocrtc->plane = plane_info;
+		ocrtc->plane_valid = TRUE;
+		return TRUE;
+	}
+
+	plane_info.enabled = 1;
+	plane_info.pos_x = 0;
+	plane_info.pos_y = 0;
+	plane_info.out_width = crtc->mode.HDisplay;
+	plane_info.out_height = crtc->mode.VDisplay;
+	plane_info.mem_idx = mem_idx;
+
+	if (ioctl (ocrtc->fd, OMAPFB_SETUP_PLANE, &plane_info)) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
+		           "%s: Plane setup failed: %s\n",
+		           __FUNCTION__, strerror(errno));
+		ocrtc->plane_valid = FALSE;
+		return FALSE;
+	}
+
+	ocrtc->plane = plane_info;
+	ocrtc->plane_valid = TRUE;
+
+	return TRUE;
+}
+
 static void
 OMAPFBCrtcDPMS (xf86CrtcPtr crtc, int mode)
 {
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+
+	/* The outputs stop the scanout, but it's off the budget either way */
+	if (mode == DPMSModeOn && crtc->enabled)
+		bw_set(&ofb->bandwidth, OMAPFBCrtcIndex(crtc),
+		       OMAPFBCrtcBandwidth(crtc));
+	else
+		bw_set(&ofb->bandwidth, OMAPFBCrtcIndex(crtc), 0);
 }
 
 static Bool
@@ -61,12 +425,55 @@ OMAPFBCrtcLock (xf86CrtcPtr crtc)
 	return FALSE;
 }
 
+/* Does the CRTC mode fit in the bandwidth budget with the other planes? */
+static Bool
+OMAPFBCrtcCheckBandwidth (xf86CrtcPtr crtc)
+{
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+	unsigned long cost = OMAPFBCrtcBandwidth(crtc);
+
+	if (bw_fits(&ofb->bandwidth, OMAPFBCrtcIndex(crtc), cost))
+		return TRUE;
+
+	xf86DrvMsg(crtc->scrn->scrnIndex, X_WARNING,
+	           "%s: %ix%i needs %lu MB/s, which is over the budget\n",
+	           __FUNCTION__, crtc->mode.HDisplay, crtc->mode.VDisplay,
+	           cost / 1000);
+	return FALSE;
+}
+
 static Bool
 OMAPFBCrtcFixMode (xf86CrtcPtr crtc,
                    DisplayModePtr mode,
                    DisplayModePtr adjusted_mode)
 {
-	/* We do not fix things... */
+	double sx, sy;
+
+	/* The only transforms we take are the ones the overlay scaler
+	 * can do, there is no shadow to fall back to
+	 */
+	if (!OMAPFBCrtcGetScale(crtc, &sx, &sy)) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_WARNING,
+		           "%s: Only scaling transforms are supported\n",
+		           __FUNCTION__);
+		return FALSE;
+	}
+
+	if (!OMAPFBCrtcScaled(crtc))
+		return OMAPFBCrtcCheckBandwidth(crtc);
+
+	if (!OMAPFB(crtc->scrn)->dss
+	 || sx < 1.0 / OMAPFB_MAX_UPSCALE || sx > OMAPFB_MAX_DOWNSCALE
+	 || sy < 1.0 / OMAPFB_MAX_UPSCALE || sy > OMAPFB_MAX_DOWNSCALE) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_WARNING,
+		           "%s: Can't scale by %gx%g\n", __FUNCTION__, sx, sy);
+		return FALSE;
+	}
+
+	if (!OMAPFBCrtcCheckBandwidth(crtc))
+		return FALSE;
+
+	/* We do not fix the mode itself... */
 	return TRUE;
 }
 
@@ -85,21 +492,42 @@ OMAPFBCrtcSetMode (xf86CrtcPtr crtc,
 {
 	crtc->mode = *mode;
 
+	/* The memory needs to be released before the outputs connect
+	 * overlays to the framebuffer
+	 */
+	if (!OMAPFBCrtcIsBase(crtc) && OMAPFBCrtcOpen(crtc))
+		OMAPFBCrtcReleaseMemory(crtc);
+
 	/* We need the output to be configured first, so defer mode setting to commit */
 }
 
+static void OMAPFBCrtcSetOrigin (xf86CrtcPtr crtc, int x, int y);
+
 static void
 OMAPFBCrtcCommitChangeMode (xf86CrtcPtr crtc)
 {
 	struct fb_var_screeninfo v;
 	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
 	DisplayModePtr mode = &crtc->mode;
+	int width, height;
 
+	if (ocrtc->fd == -1)
+		return;
+
+	/* Secondary CRTCs need to match the base framebuffer layout */
 	v = ofb->state_info;
-	v.xres = mode->HDisplay;
-	v.yres = mode->VDisplay;
+	v.rotate = OMAPFBCrtcFBRotation(crtc->rotation);
+	/* The resolution is what we see, the rotation engine and the
+	 * overlay scaler turn it to fit the display
+	 */
+	OMAPFBCrtcFramebufferSize(crtc, &width, &height);
+	v.xres = width;
+	v.yres = height;
 	v.xres_virtual = crtc->scrn->virtualX;
-	v.yres_virtual = crtc->scrn->virtualY;
+	v.yres_virtual = crtc->scrn->virtualY * ofb->pages;
+	v.xoffset = crtc->x;
+	v.yoffset = crtc->y + ofb->front_page * crtc->scrn->virtualY;
 	v.activate = FB_ACTIVATE_NOW;
 	v.pixclock = KHZ2PICOS(mode->Clock ? mode->Clock : 56000);
 	v.left_margin = mode->HTotal - mode->HSyncEnd;
@@ -109,20 +537,76 @@ OMAPFBCrtcCommitChangeMode (xf86CrtcPtr crtc)
 	v.hsync_len = mode->HSyncEnd - mode->HSyncStart;
 	v.vsync_len = mode->VSyncEnd - mode->VSyncStart;
 
-	if (ioctl (ofb->fd, FBIOPUT_VSCREENINFO, &v))
+	/* A manual update display needs all of what it now shows sent */
+	if (ofb->manual_update) {
+		BoxRec box;
+
+		box.x1 = crtc->x;
+		box.y1 = crtc->y;
+		box.x2 = crtc->x + width;
+		box.y2 = crtc->y + height;
+		OMAPFBDamageUpdate(crtc->scrn, &box);
+	}
+
+	if (!OMAPFBCrtcIsBase(crtc) && !OMAPFBCrtcSetupPlane(crtc))
+		return;
+
+	/* Setting the same mode again (like when RandR just turns an output
+	 * on) would only blank the display for a while. When only the
+	 * viewport moved, panning is enough.
+	 */
+	if (ocrtc->committed_valid && OMAPFBCrtcSameMode(&ocrtc->committed, &v)) {
+		if (ocrtc->committed.xoffset != v.xoffset
+		 || ocrtc->committed.yoffset != v.yoffset)
+			OMAPFBCrtcSetOrigin(crtc, crtc->x, crtc->y);
+		if (OMAPFBCrtcIsBase(crtc) && ofb->dss)
+			OMAPFBCrtcSetupPlane(crtc);
+		return;
+	}
+
+	/* The output may have changed, find out if it needs to be sent
+	 * updates
+	 */
+	if (ofb->manual_update) {
+		int update_mode;
+
+		ocrtc->manual_update =
+			ioctl (ocrtc->fd, OMAPFB_GET_UPDATE_MODE, &update_mode) != 0
+			|| update_mode == OMAPFB_MANUAL_UPDATE;
+	}
+
+	ocrtc->committed_valid = FALSE;
+	ocrtc->plane_valid = FALSE;
+	if (ioctl (ocrtc->fd, FBIOPUT_VSCREENINFO, &v))
 	{
 		xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
 		           "%s: Setting mode failed: %s\n",
 		           __FUNCTION__, strerror(errno));
+	} else {
+		ocrtc->committed = v;
+		ocrtc->committed_valid = TRUE;
+		bw_set(&ofb->bandwidth, OMAPFBCrtcIndex(crtc),
+		       OMAPFBCrtcBandwidth(crtc));
 	}
 
-	if (ioctl (ofb->fd, FBIOGET_VSCREENINFO, &ofb->state_info))
+	if (ioctl (ocrtc->fd, FBIOGET_VSCREENINFO, &ocrtc->state_info))
 	{
 		xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
 		           "%s: Reading resolution info failed: %s\n",
 		           __FUNCTION__, strerror(errno));
 	}
 
+	if (!OMAPFBCrtcIsBase(crtc))
+		return;
+
+	/* The overlay keeps its output size over resolution changes if it
+	 * can scale, so set it for the new mode
+	 */
+	if (ofb->dss)
+		OMAPFBCrtcSetupPlane(crtc);
+
+	ofb->state_info = ocrtc->state_info;
+
 	if (ioctl (ofb->fd, FBIOGET_FSCREENINFO, &ofb->fixed_info)) {
 		xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
 		           "%s: Reading hardware info failed: %s\n",
@@ -135,6 +619,128 @@ OMAPFBCrtcCommitChangeMode (xf86CrtcPtr crtc)
 
 }
 
+/* Moves the viewport of the CRTC by just panning the framebuffer */
+static void
+OMAPFBCrtcSetOrigin (xf86CrtcPtr crtc, int x, int y)
+{
+	struct fb_var_screeninfo v;
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+
+	if (ocrtc->fd == -1)
+		return;
+
+	/* Look at the page currently shown */
+	y += ofb->front_page * crtc->scrn->virtualY;
+
+	v = ocrtc->state_info;
+	v.xoffset = x;
+	v.yoffset = y;
+	v.activate = FB_ACTIVATE_NOW;
+
+	if (ioctl (ocrtc->fd, FBIOPAN_DISPLAY, &v)) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_ERROR,
+		           "%s: Panning to %i,%i failed: %s\n",
+		           __FUNCTION__, x, y, strerror(errno));
+		return;
+	}
+
+	ocrtc->state_info.xoffset = x;
+	ocrtc->state_info.yoffset = y;
+	ocrtc->committed.xoffset = x;
+	ocrtc->committed.yoffset = y;
+	if (OMAPFBCrtcIsBase(crtc)) {
+		ofb->state_info.xoffset = x;
+		ofb->state_info.yoffset = y;
+	}
+}
+
+/* We have the rotation engines do the work, so instead of letting the
+ * server set up a shadow for rotation we run the mode set ourselves
+ */
+static Bool
+OMAPFBCrtcSetModeMajor (xf86CrtcPtr crtc, DisplayModePtr mode,
+                        Rotation rotation, int x, int y)
+{
+	ScrnInfoPtr pScrn = crtc->scrn;
+	xf86CrtcConfigPtr config = XF86_CRTC_CONFIG_PTR(pScrn);
+	DisplayModeRec saved_mode = crtc->mode;
+	DisplayModeRec adjusted_mode;
+	Rotation saved_rotation = crtc->rotation;
+	int saved_x = crtc->x;
+	int saved_y = crtc->y;
+	int i;
+
+	if (!(rotation & OMAPFBCrtcRotations(pScrn))) {
+		xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+		           "%s: Rotation 0x%x not supported\n",
+		           __FUNCTION__, rotation);
+		return FALSE;
+	}
+
+	crtc->mode = *mode;
+	crtc->x = x;
+	crtc->y = y;
+	crtc->rotation = rotation;
+
+	/* Let the outputs and the CRTC adjust the mode */
+	adjusted_mode = *mode;
+	for (i = 0; i < config->num_output; i++) {
+		xf86OutputPtr output = config->output[i];
+		if (output->crtc != crtc)
+			continue;
+		if (!output->funcs->mode_fixup(output, mode, &adjusted_mode))
+			goto fail;
+	}
+	if (!crtc->funcs->mode_fixup(crtc, mode, &adjusted_mode))
+		goto fail;
+
+	/* Same order as the server would do it */
+	for (i = 0; i < config->num_output; i++) {
+		xf86OutputPtr output = config->output[i];
+		if (output->crtc == crtc)
+			output->funcs->prepare(output);
+	}
+	crtc->funcs->prepare(crtc);
+
+	crtc->funcs->mode_set(crtc, mode, &adjusted_mode, x, y);
+	for (i = 0; i < config->num_output; i++) {
+		xf86OutputPtr output = config->output[i];
+		if (output->crtc == crtc)
+			output->funcs->mode_set(output, mode, &adjusted_mode);
+	}
+
+	crtc->funcs->commit(crtc);
+	for (i = 0; i < config->num_output; i++) {
+		xf86OutputPtr output = config->output[i];
+		if (output->crtc == crtc)
+			output->funcs->commit(output);
+	}
+
+	/* Nothing gets rotated in software, but the cursor code needs to
+	 * know how screen coordinates map to the display
+	 */
+	crtc->transform_in_use =
+		RRTransformCompute(x, y, mode->HDisplay, mode->VDisplay,
+		                   rotation,
+		                   crtc->transformPresent ? &crtc->transform : NULL,
+		                   &crtc->crtc_to_framebuffer,
+		                   &crtc->f_crtc_to_framebuffer,
+		                   &crtc->f_framebuffer_to_crtc);
+
+	if (pScrn->pScreen != NULL)
+		xf86_reload_cursors(pScrn->pScreen);
+
+	return TRUE;
+
+fail:
+	crtc->mode = saved_mode;
+	crtc->x = saved_x;
+	crtc->y = saved_y;
+	crtc->rotation = saved_rotation;
+	return FALSE;
+}
+
 static void *
 OMAPFBCrtcShadowAllocate (xf86CrtcPtr crtc, int width, int height)
 {
@@ -149,7 +755,73 @@ OMAPFBCrtcSetGamma (xf86CrtcPtr crtc,
                     CARD16 *red, CARD16 *green, CARD16 *blue,
                     int size)
 {
-	/* Here just because the server tends to crash without... */
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+	CARD8 gamma[3][256];
+	CARD16 r[256], g[256], b[256];
+	struct fb_fix_screeninfo fix;
+	struct fb_cmap cmap;
+	int i;
+
+	if (ocrtc->fd == -1 || ocrtc->gamma_unsupported)
+		return;
+
+	/* Only directcolor runs the pixels through the colormap. With
+	 * truecolor the kernel takes the ramps as the 16 entry console
+	 * palette, and nothing on the screen changes.
+	 */
+	if (ocrtc->gamma_size == 0) {
+		if (ioctl(ocrtc->fd, FBIOGET_FSCREENINFO, &fix)
+		 || fix.visual != FB_VISUAL_DIRECTCOLOR) {
+			xf86DrvMsg(crtc->scrn->scrnIndex, X_INFO,
+			           "%s: No gamma ramps on /dev/fb%i\n",
+			           __FUNCTION__, ocrtc->fb_idx);
+			ocrtc->gamma_unsupported = TRUE;
+			return;
+		}
+	}
+
+	if (size > 256)
+		size = 256;
+
+	/* The hardware does 8 bits per channel at best, so ramps that only
+	 * differ below that (color tools ramping slowly) are all the same
+	 */
+	for (i = 0; i < size; i++) {
+		gamma[0][i] = red[i] >> 8;
+		gamma[1][i] = green[i] >> 8;
+		gamma[2][i] = blue[i] >> 8;
+	}
+
+	if (size == ocrtc->gamma_size
+	 && memcmp(gamma[0], ocrtc->gamma[0], size) == 0
+	 && memcmp(gamma[1], ocrtc->gamma[1], size) == 0
+	 && memcmp(gamma[2], ocrtc->gamma[2], size) == 0)
+		return;
+
+	for (i = 0; i < size; i++) {
+		r[i] = gamma[0][i] << 8 | gamma[0][i];
+		g[i] = gamma[1][i] << 8 | gamma[1][i];
+		b[i] = gamma[2][i] << 8 | gamma[2][i];
+	}
+
+	cmap.start = 0;
+	cmap.len = size;
+	cmap.red = r;
+	cmap.green = g;
+	cmap.blue = b;
+	cmap.transp = NULL;
+
+	if (ioctl(ocrtc->fd, FBIOPUTCMAP, &cmap)) {
+		xf86DrvMsg(crtc->scrn->scrnIndex, X_WARNING,
+		           "%s: Gamma ramps not supported on /dev/fb%i: %s\n",
+		           __FUNCTION__, ocrtc->fb_idx, strerror(errno));
+		ocrtc->gamma_unsupported = TRUE;
+		return;
+	}
+
+	ocrtc->gamma_size = size;
+	for (i = 0; i < 3; i++)
+		memcpy(ocrtc->gamma[i], gamma[i], size);
 }
 
 static xf86CrtcFuncsRec OMAPFBCrtcFuncs = {
@@ -166,29 +838,117 @@ static xf86CrtcFuncsRec OMAPFBCrtcFuncs = {
 	OMAPFBCrtcShadowAllocate, /* Shadow allocate */
 	NULL, /* Shadow create */
 	NULL, /* Shadow destroy */
-	NULL, /* Cursor colors */
-	NULL, /* Set cursor position */
-	NULL, /* Show cursor */
-	NULL, /* Hide cursor */
+	OMAPFBCrtcSetCursorColors, /* Cursor colors */
+	OMAPFBCrtcSetCursorPosition, /* Set cursor position */
+	OMAPFBCrtcShowCursor, /* Show cursor */
+	OMAPFBCrtcHideCursor, /* Hide cursor */
 	NULL, /* Load cursor image */
-	NULL, /* Load cursor argb */
+	OMAPFBCrtcLoadCursorARGB, /* Load cursor argb */
 	NULL, /* Destroy */
-	NULL, /* Set mode major */
-	NULL  /* Set origin (panning) */	
+	OMAPFBCrtcSetModeMajor, /* Set mode major */
+	OMAPFBCrtcSetOrigin  /* Set origin (panning) */
 };
 
 
+/* Finds the index of the framebuffer device we were given */
+static int
+OMAPFBBaseFramebuffer (OMAPFBPtr ofb)
+{
+	int idx;
+
+	if (sscanf(ofb->fb_path, "/dev/fb%i", &idx) != 1)
+		idx = 0;
+
+	return idx;
+}
+
+/* Rotation is done by the DSS rotation engines (VRFB or TILER), which
+ * can do all of them. Without those, DMA can only flip upside down.
+ * The kernel values for rotate_type are 0 for DMA, 1 for VRFB and 2 for
+ * TILER.
+ */
+Rotation
+OMAPFBCrtcRotations (ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	char value[8];
+	int type;
+
+	if (!ofb->dss) {
+		if (ofb->caps.ctrl & OMAPFB_CAPS_WINDOW_ROTATE)
+			return RR_Rotate_0 | RR_Rotate_90 | RR_Rotate_180 | RR_Rotate_270;
+		return RR_Rotate_0;
+	}
+
+	if (read_fb_sysfs_value(OMAPFBBaseFramebuffer(ofb), "rotate_type",
+	                        value, sizeof(value)) <= 0)
+		return RR_Rotate_0;
+
+	type = atoi(value);
+	if (type == 1 || type == 2)
+		return RR_Rotate_0 | RR_Rotate_90 | RR_Rotate_180 | RR_Rotate_270;
+
+	return RR_Rotate_0 | RR_Rotate_180;
+}
+
+/* Maps a rectangle of the screen to the display of the base CRTC, for
+ * planes that are positioned in display coordinates
+ */
+void
+OMAPFBCrtcTransformRect (ScrnInfoPtr pScrn, int *x, int *y, int *w, int *h)
+{
+	xf86CrtcPtr crtc = OMAPFB(pScrn)->crtcs[0];
+	double sx, sy;
+	int lx, ly, lw, lh;
+
+	/* Undo the scaling first... */
+	OMAPFBCrtcGetScale(crtc, &sx, &sy);
+	lx = (int)((*x - crtc->x) / sx);
+	ly = (int)((*y - crtc->y) / sy);
+	lw = (int)(*w / sx);
+	lh = (int)(*h / sy);
+
+	/* ...then the rotation */
+
+	switch (crtc->rotation & 0xf) {
+		case RR_Rotate_90:
+			*x = ly;
+			*y = crtc->mode.VDisplay - lx - lw;
+			*w = lh;
+			*h = lw;
+			break;
+		case RR_Rotate_180:
+			*x = crtc->mode.HDisplay - lx - lw;
+			*y = crtc->mode.VDisplay - ly - lh;
+			break;
+		case RR_Rotate_270:
+			*x = crtc->mode.HDisplay - ly - lh;
+			*y = lx;
+			*w = lh;
+			*h = lw;
+			break;
+		case RR_Rotate_0:
+		default:
+			*x = lx;
+			*y = ly;
+			break;
+	}
+}
+
 void
 OMAPFBCRTCInit(ScrnInfoPtr pScrn)
 {
 	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int i, n = 1;
+	int base_fb = OMAPFBBaseFramebuffer(ofb);
+	int fb = 0;
+
 	xf86CrtcConfigInit(pScrn, &OMAPFBCrtcConfigFuncs);
 
-	/* We can support small sizes with output scaling (pixel doubling)
-	 * and in theory multiple (unique) outputs with large virtual
-	 * resolution by scanning out different parts of the the framebuffer.
-	 * In practise, this doesn't seem to be supported.
-	 * (no way to setup the overlay offset/base address)
+	/* We can support small sizes with output scaling, through a RandR
+	 * scaling transform on a video overlay (see OMAPFBCrtcFixMode).
+	 * Multiple (unique) outputs get their own CRTC, each scanning out
+	 * a part of the virtual resolution of the base framebuffer.
 	 */
 	 /* FIXME: figure out what makes sense here. A known max resolution?
 	  * framebuffer size?
@@ -196,7 +956,38 @@ OMAPFBCRTCInit(ScrnInfoPtr pScrn)
 	xf86CrtcSetSizeRange(pScrn,
 	                     8, 8, 2048, 2048);
 
-	ofb->crtc = xf86CrtcCreate(pScrn, &OMAPFBCrtcFuncs);
-}
+	/* With DSS, each overlay manager can show a different framebuffer */
+	if (ofb->dss && ofb->ovlPool != NULL) {
+		n = ofb->ovlPool->managers;
+		if (n > ofb->ovlPool->framebuffers)
+			n = ofb->ovlPool->framebuffers;
+		if (n > OMAPFB_MAX_DISPLAYS)
+			n = OMAPFB_MAX_DISPLAYS;
+		if (n < 1)
+			n = 1;
+	}
+
+	for (i = 0; i < n; i++) {
+		OMAPFBCrtcPtr ocrtc = xnfcalloc(sizeof(OMAPFBCrtcRec), 1);
 
+		if (i == 0) {
+			ocrtc->fd = ofb->fd;
+			ocrtc->fb_idx = base_fb;
+			ocrtc->state_info = ofb->state_info;
+		} else {
+			/* The rest of the framebuffers, in order */
+			if (fb == base_fb)
+				fb++;
+			ocrtc->fd = -1;
+			ocrtc->fb_idx = fb++;
+		}
+
+		ofb->crtcs[i] = xf86CrtcCreate(pScrn, &OMAPFBCrtcFuncs);
+		ofb->crtcs[i]->driver_private = ocrtc;
+	}
+	ofb->num_crtcs = n;
+
+	xf86DrvMsg(pScrn->scrnIndex, X_INFO, "%s: %i CRTC(s)\n",
+	           __FUNCTION__, n);
+}
 
@@ -26,5 +26,26 @@
 
 void OMAPFBCRTCInit(ScrnInfoPtr pScrn);
 
+/* Does the CRTC need an overlay that can scale? */
+Bool OMAPFBCrtcScaled(xf86CrtcPtr crtc);
+
+/* Scanout bandwidth in kB/s of a plane of the given size shown on the
+ * CRTC at its current mode
+ */
+unsigned long OMAPFBCrtcPlaneBandwidth(xf86CrtcPtr crtc,
+                                       int src_w, int src_h, int bpp,
+                                       int out_w, int out_h);
+
+/* Rotations the hardware can do for us */
+Rotation OMAPFBCrtcRotations(ScrnInfoPtr pScrn);
+
+/* Maps a rectangle of the screen to the (possibly rotated) display of
+ * the base CRTC
+ */
+void OMAPFBCrtcTransformRect(ScrnInfoPtr pScrn, int *x, int *y, int *w, int *h);
+
+/* Sets the virtual resolution of the framebuffer all CRTCs scan out from */
+Bool OMAPFBSetVirtualSize(ScrnInfoPtr pScrn, int width, int height);
+
 #endif /* __OMAPFB_DRIVER_H__ */
 
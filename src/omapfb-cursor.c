@@ -0,0 +1,551 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * Hardware cursor through a spare DSS overlay
+ *
+ * The cursor framebuffer is laid out as a column of image slots, each
+ * OMAPFB_CURSOR_SIZE square and surrounded by transparent padding of the
+ * same size:
+ *
+ *   +---+---+---+
+ *   |   |   |   |
+ *   +---+---+---+
+ *   |   | 0 |   |
+ *   +---+---+---+
+ *   |   |   |   |
+ *   +---+---+---+
+ *   |   | 1 |   |
+ *   ...
+ *
+ * The overlay always stays fully on the screen (DSS won't take it
+ * otherwise), and at the screen edges the image is moved inside the
+ * overlay by panning into the padding. Moving the cursor thus costs
+ * a plane setup and sometimes a pan, but no pixels are written.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xorg-server.h"
+#include "xf86.h"
+#include "xf86Crtc.h"
+#include "xf86Cursor.h"
+
+#include "omapfb-driver.h"
+#include "omapfb-crtc.h"
+#include "omapfb-cursor.h"
+#include "omapfb-damage.h"
+#include "omapfb-overlay-pool.h"
+#include "omapfb-utils.h"
+#include "image-format-conversions.h"
+
+#define CURSOR_BPP 4
+#define CURSOR_WIDTH (3 * OMAPFB_CURSOR_SIZE)
+#define CURSOR_HEIGHT (OMAPFB_CURSOR_SIZE * (1 + 2 * OMAPFB_CURSOR_SLOTS))
+#define CURSOR_IMAGE_SIZE (OMAPFB_CURSOR_SIZE * OMAPFB_CURSOR_SIZE)
+
+/* First line of the image in a slot */
+#define CURSOR_SLOT_Y(slot) (OMAPFB_CURSOR_SIZE * (1 + 2 * (slot)))
+
+static CARD32
+OMAPFBCursorHash(CARD32 *image)
+{
+	CARD32 hash = 0;
+	int i;
+
+	for (i = 0; i < CURSOR_IMAGE_SIZE; i++)
+		hash = (hash << 5) + hash + image[i];
+
+	return hash;
+}
+
+/* Picks the last framebuffer that none of the CRTCs use */
+static int
+OMAPFBCursorFindFramebuffer(OMAPFBPtr ofb)
+{
+	int fb, i;
+
+	for (fb = ofb->ovlPool->framebuffers - 1; fb >= 0; fb--) {
+		Bool used = FALSE;
+
+		for (i = 0; i < ofb->num_crtcs; i++) {
+			OMAPFBCrtcPtr ocrtc = ofb->crtcs[i]->driver_private;
+			if (ocrtc->fb_idx == fb)
+				used = TRUE;
+		}
+		if (!used)
+			return fb;
+	}
+
+	return -1;
+}
+
+static Bool
+OMAPFBCursorSetupFramebuffer(ScrnInfoPtr pScrn, OMAPFBCursorPtr cursor)
+{
+	struct omapfb_mem_info mem_info;
+	struct fb_fix_screeninfo fixed_info;
+	char path[32];
+
+	snprintf(path, 32, "/dev/fb%i", cursor->fb_idx);
+	cursor->fd = open(path, O_RDWR, 0);
+	if (cursor->fd == -1) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR, "%s: Opening %s failed: %s\n",
+		           __FUNCTION__, path, strerror(errno));
+		return FALSE;
+	}
+
+	/* The memory can only be changed while the plane is off */
+	if (ioctl(cursor->fd, OMAPFB_QUERY_PLANE, &cursor->plane_info)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR, "%s: Reading plane info failed\n",
+		           __FUNCTION__);
+		return FALSE;
+	}
+	cursor->plane_info.enabled = 0;
+	ioctl(cursor->fd, OMAPFB_SETUP_PLANE, &cursor->plane_info);
+
+	memset(&mem_info, 0, sizeof(mem_info));
+	mem_info.size = CURSOR_WIDTH * CURSOR_HEIGHT * CURSOR_BPP;
+	mem_info.type = OMAPFB_MEMTYPE_SDRAM;
+	if (ioctl(cursor->fd, OMAPFB_SETUP_MEM, &mem_info)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Allocating cursor memory failed: %s\n",
+		           __FUNCTION__, strerror(errno));
+		return FALSE;
+	}
+
+	/* ARGB8888, showing one image at a time */
+	if (ioctl(cursor->fd, FBIOGET_VSCREENINFO, &cursor->state_info)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR, "%s: Reading state info failed\n",
+		           __FUNCTION__);
+		return FALSE;
+	}
+	cursor->state_info.xres = OMAPFB_CURSOR_SIZE;
+	cursor->state_info.yres = OMAPFB_CURSOR_SIZE;
+	cursor->state_info.xres_virtual = CURSOR_WIDTH;
+	cursor->state_info.yres_virtual = CURSOR_HEIGHT;
+	cursor->state_info.xoffset = OMAPFB_CURSOR_SIZE;
+	cursor->state_info.yoffset = CURSOR_SLOT_Y(0);
+	cursor->state_info.bits_per_pixel = CURSOR_BPP * 8;
+	cursor->state_info.transp.offset = 24;
+	cursor->state_info.transp.length = 8;
+	cursor->state_info.red.offset = 16;
+	cursor->state_info.red.length = 8;
+	cursor->state_info.green.offset = 8;
+	cursor->state_info.green.length = 8;
+	cursor->state_info.blue.offset = 0;
+	cursor->state_info.blue.length = 8;
+	cursor->state_info.nonstd = 0;
+	cursor->state_info.rotate = 0;
+	cursor->state_info.activate = FB_ACTIVATE_NOW;
+	if (ioctl(cursor->fd, FBIOPUT_VSCREENINFO, &cursor->state_info)
+	 || ioctl(cursor->fd, FBIOGET_VSCREENINFO, &cursor->state_info)
+	 || ioctl(cursor->fd, FBIOGET_FSCREENINFO, &fixed_info)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Setting up the cursor framebuffer failed: %s\n",
+		           __FUNCTION__, strerror(errno));
+		return FALSE;
+	}
+
+	cursor->stride = fixed_info.line_length;
+	cursor->mem_size = mem_info.size;
+	cursor->mem = mmap(NULL, cursor->mem_size, PROT_READ | PROT_WRITE,
+	                   MAP_SHARED, cursor->fd, 0);
+	if (cursor->mem == MAP_FAILED) {
+		cursor->mem = NULL;
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Mapping cursor memory failed\n", __FUNCTION__);
+		return FALSE;
+	}
+
+	/* The padding must stay transparent */
+	memset(cursor->mem, 0, cursor->mem_size);
+
+	return TRUE;
+}
+
+static void
+OMAPFBCursorFree(OMAPFBCursorPtr cursor)
+{
+	int i;
+
+	if (cursor->mem != NULL)
+		munmap(cursor->mem, cursor->mem_size);
+	if (cursor->fd != -1)
+		close(cursor->fd);
+	for (i = 0; i < OMAPFB_CURSOR_SLOTS; i++)
+		free(cursor->image[i]);
+	free(cursor);
+}
+
+/* Connects the cursor overlay to the display the CRTC drives */
+static Bool
+OMAPFBCursorAttach(OMAPFBPtr ofb, xf86CrtcPtr crtc)
+{
+	xf86CrtcConfigPtr config = XF86_CRTC_CONFIG_PTR(crtc->scrn);
+	OMAPFBCursorPtr cursor = ofb->cursor;
+	int i, mgr;
+
+	for (i = 0; i < config->num_output; i++) {
+		if (config->output[i]->crtc == crtc)
+			break;
+	}
+	if (i == config->num_output)
+		return FALSE;
+
+	if (!overlayPoolConnect(ofb->ovlPool, cursor->fb_idx, cursor->overlay,
+	                        config->output[i]->name))
+		return FALSE;
+	overlayPoolApplyConnections(ofb->ovlPool);
+
+	/* The cursor needs per-pixel alpha, which is a property of the
+	 * manager. Not every manager has it, and OMAP4 can take the X
+	 * premultiplied ARGB as it is; without those we do what we can.
+	 */
+	mgr = ofb->ovlPool->mgr_map[cursor->overlay];
+	write_dss_sysfs_value("manager", mgr, "alpha_blending_enabled", "1");
+	write_dss_sysfs_value("overlay", cursor->overlay, "pre_mult_alpha", "1");
+
+	cursor->crtc = crtc;
+
+	return TRUE;
+}
+
+/* Manual update displays have to be sent where the overlay is, both
+ * before and after it changes
+ */
+static void
+OMAPFBCursorDamage(OMAPFBCursorPtr cursor)
+{
+	xf86CrtcPtr crtc = cursor->crtc;
+	OMAPFBCrtcPtr ocrtc;
+	BoxRec box;
+
+	if (crtc == NULL)
+		return;
+	ocrtc = crtc->driver_private;
+
+	/* The overlay is placed in display pixels, which don't map to
+	 * the screen one to one when the CRTC scales
+	 */
+	if (OMAPFBCrtcScaled(crtc)) {
+		box.x1 = crtc->x;
+		box.y1 = crtc->y;
+		box.x2 = crtc->x + ocrtc->state_info.xres;
+		box.y2 = crtc->y + ocrtc->state_info.yres;
+	} else {
+		box.x1 = crtc->x + cursor->plane_info.pos_x;
+		box.y1 = crtc->y + cursor->plane_info.pos_y;
+		box.x2 = box.x1 + OMAPFB_CURSOR_SIZE;
+		box.y2 = box.y1 + OMAPFB_CURSOR_SIZE;
+	}
+
+	OMAPFBDamageUpdate(crtc->scrn, &box);
+}
+
+/* Moves the overlay to show the cursor at x, y of the CRTC */
+static void
+OMAPFBCursorMove(OMAPFBCursorPtr cursor, xf86CrtcPtr crtc, int x, int y)
+{
+	int w = crtc->mode.HDisplay;
+	int h = crtc->mode.VDisplay;
+	int pos_x = x, pos_y = y;
+	int xoffset, yoffset;
+	Bool changed = FALSE;
+
+	/* Keep the overlay on the screen... */
+	if (pos_x > w - OMAPFB_CURSOR_SIZE)
+		pos_x = w - OMAPFB_CURSOR_SIZE;
+	if (pos_x < 0)
+		pos_x = 0;
+	if (pos_y > h - OMAPFB_CURSOR_SIZE)
+		pos_y = h - OMAPFB_CURSOR_SIZE;
+	if (pos_y < 0)
+		pos_y = 0;
+
+	/* ...and the image where it should be, inside of it */
+	xoffset = OMAPFB_CURSOR_SIZE + pos_x - x;
+	yoffset = CURSOR_SLOT_Y(cursor->current_slot) + pos_y - y;
+
+	if (xoffset != cursor->state_info.xoffset
+	 || yoffset != cursor->state_info.yoffset) {
+		cursor->state_info.xoffset = xoffset;
+		cursor->state_info.yoffset = yoffset;
+		if (ioctl(cursor->fd, FBIOPAN_DISPLAY, &cursor->state_info)) {
+			xf86Msg(X_ERROR, "%s: Panning cursor failed: %s\n",
+			        __FUNCTION__, strerror(errno));
+		}
+		changed = TRUE;
+	}
+
+	if (pos_x != cursor->plane_info.pos_x
+	 || pos_y != cursor->plane_info.pos_y) {
+		if (cursor->visible)
+			OMAPFBCursorDamage(cursor);
+		changed = TRUE;
+		cursor->plane_info.pos_x = pos_x;
+		cursor->plane_info.pos_y = pos_y;
+		if (cursor->visible
+		 && ioctl(cursor->fd, OMAPFB_SETUP_PLANE, &cursor->plane_info)) {
+			xf86Msg(X_ERROR, "%s: Moving cursor failed: %s\n",
+			        __FUNCTION__, strerror(errno));
+		}
+	}
+
+	if (changed && cursor->visible)
+		OMAPFBCursorDamage(cursor);
+}
+
+static void
+OMAPFBCursorSetVisible(OMAPFBCursorPtr cursor, Bool visible)
+{
+	if (cursor->visible == visible)
+		return;
+
+	cursor->plane_info.enabled = visible;
+	cursor->plane_info.out_width = OMAPFB_CURSOR_SIZE;
+	cursor->plane_info.out_height = OMAPFB_CURSOR_SIZE;
+	if (ioctl(cursor->fd, OMAPFB_SETUP_PLANE, &cursor->plane_info)) {
+		xf86Msg(X_ERROR, "%s: Plane setup failed: %s\n",
+		        __FUNCTION__, strerror(errno));
+		cursor->plane_info.enabled = 0;
+	}
+	cursor->visible = cursor->plane_info.enabled;
+
+	OMAPFBCursorDamage(cursor);
+}
+
+/* Takes the overlay over to the CRTC and shows it there */
+static void
+OMAPFBCursorShowOn(OMAPFBPtr ofb, xf86CrtcPtr crtc)
+{
+	OMAPFBCursorPtr cursor = ofb->cursor;
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+
+	if (cursor->crtc != crtc) {
+		OMAPFBCursorSetVisible(cursor, FALSE);
+		if (!OMAPFBCursorAttach(ofb, crtc))
+			return;
+	}
+
+	OMAPFBCursorMove(cursor, crtc, ocrtc->cursor_x, ocrtc->cursor_y);
+	OMAPFBCursorSetVisible(cursor, TRUE);
+}
+
+/*** CRTC hooks */
+
+void
+OMAPFBCrtcSetCursorColors(xf86CrtcPtr crtc, int bg, int fg)
+{
+	/* The colors are already in the ARGB image */
+}
+
+void
+OMAPFBCrtcSetCursorPosition(xf86CrtcPtr crtc, int x, int y)
+{
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+
+	ocrtc->cursor_x = x;
+	ocrtc->cursor_y = y;
+
+	if (ofb->cursor == NULL)
+		return;
+
+	/* There's only one overlay for all CRTCs. It stays where it is
+	 * while it is visible there, even if the cursor is partly on
+	 * this CRTC too.
+	 */
+	if (ofb->cursor->crtc == crtc)
+		OMAPFBCursorMove(ofb->cursor, crtc, x, y);
+	else if (!ofb->cursor->visible && crtc->cursor_shown)
+		OMAPFBCursorShowOn(ofb, crtc);
+}
+
+void
+OMAPFBCrtcShowCursor(xf86CrtcPtr crtc)
+{
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+
+	if (ofb->cursor == NULL)
+		return;
+
+	if (ofb->cursor->crtc == crtc || !ofb->cursor->visible)
+		OMAPFBCursorShowOn(ofb, crtc);
+}
+
+void
+OMAPFBCrtcHideCursor(xf86CrtcPtr crtc)
+{
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+	int i;
+
+	if (ofb->cursor == NULL || ofb->cursor->crtc != crtc)
+		return;
+
+	OMAPFBCursorSetVisible(ofb->cursor, FALSE);
+
+	/* Carry on on another CRTC the cursor is still on */
+	for (i = 0; i < ofb->num_crtcs; i++) {
+		xf86CrtcPtr other = ofb->crtcs[i];
+		if (other != crtc && other->enabled && other->cursor_shown) {
+			OMAPFBCursorShowOn(ofb, other);
+			break;
+		}
+	}
+}
+
+void
+OMAPFBCrtcLoadCursorARGB(xf86CrtcPtr crtc, CARD32 *image)
+{
+	OMAPFBPtr ofb = OMAPFB(crtc->scrn);
+	OMAPFBCursorPtr cursor = ofb->cursor;
+	CARD32 hash;
+	int i, slot = -1;
+
+	if (cursor == NULL)
+		return;
+
+	/* The image gets loaded for each CRTC, and the same few cursors
+	 * tend to come back over and over. Only new ones are written to
+	 * the (uncached) cursor memory.
+	 */
+	hash = OMAPFBCursorHash(image);
+	for (i = 0; i < OMAPFB_CURSOR_SLOTS; i++) {
+		if (cursor->image[i] != NULL && cursor->hash[i] == hash
+		 && memcmp(cursor->image[i], image, CURSOR_IMAGE_SIZE * CURSOR_BPP) == 0) {
+			slot = i;
+			break;
+		}
+	}
+
+	if (slot == -1) {
+		slot = (cursor->current_slot + 1) % OMAPFB_CURSOR_SLOTS;
+
+		if (cursor->image[slot] == NULL)
+			cursor->image[slot] = malloc(CURSOR_IMAGE_SIZE * CURSOR_BPP);
+		if (cursor->image[slot] == NULL)
+			return;
+
+		memcpy(cursor->image[slot], image, CURSOR_IMAGE_SIZE * CURSOR_BPP);
+		cursor->hash[slot] = hash;
+
+		rect_copy(OMAPFB_CURSOR_SIZE * CURSOR_BPP, OMAPFB_CURSOR_SIZE,
+		          OMAPFB_CURSOR_SIZE * CURSOR_BPP, cursor->stride,
+		          (uint8_t *)image,
+		          cursor->mem + CURSOR_SLOT_Y(slot) * cursor->stride
+		                      + OMAPFB_CURSOR_SIZE * CURSOR_BPP);
+	}
+
+	if (slot == cursor->current_slot)
+		return;
+
+	/* Switching images is just a pan to the other slot */
+	cursor->current_slot = slot;
+	if (cursor->crtc != NULL) {
+		OMAPFBCrtcPtr ocrtc = cursor->crtc->driver_private;
+		OMAPFBCursorMove(cursor, cursor->crtc,
+		                 ocrtc->cursor_x, ocrtc->cursor_y);
+	}
+}
+
+/*** Public API below this */
+
+Bool
+OMAPFBCursorInit(ScreenPtr pScreen)
+{
+	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	OMAPFBCursorPtr cursor;
+
+	if (!ofb->dss || ofb->ovlPool == NULL)
+		return FALSE;
+
+	cursor = calloc(1, sizeof(OMAPFBCursorRec));
+	if (cursor == NULL)
+		return FALSE;
+	cursor->fd = -1;
+	/* Nothing uploaded yet, the first image goes to slot 0 */
+	cursor->current_slot = OMAPFB_CURSOR_SLOTS - 1;
+
+	cursor->fb_idx = OMAPFBCursorFindFramebuffer(ofb);
+	if (cursor->fb_idx == -1) {
+		xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+		           "No free framebuffer for the hardware cursor\n");
+		OMAPFBCursorFree(cursor);
+		return FALSE;
+	}
+
+	if (!OMAPFBCursorSetupFramebuffer(pScrn, cursor)) {
+		OMAPFBCursorFree(cursor);
+		return FALSE;
+	}
+
+	cursor->overlay = overlayPoolReserveOverlay(ofb->ovlPool);
+	if (cursor->overlay == -1) {
+		xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+		           "No free overlay for the hardware cursor\n");
+		OMAPFBCursorFree(cursor);
+		return FALSE;
+	}
+
+	ofb->cursor = cursor;
+
+	if (!xf86_cursors_init(pScreen, OMAPFB_CURSOR_SIZE, OMAPFB_CURSOR_SIZE,
+	                       HARDWARE_CURSOR_TRUECOLOR_AT_8BPP |
+	                       HARDWARE_CURSOR_SOURCE_MASK_INTERLEAVE_64 |
+	                       HARDWARE_CURSOR_UPDATE_UNHIDDEN |
+	                       HARDWARE_CURSOR_ARGB)) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Hardware cursor initialization failed\n",
+		           __FUNCTION__);
+		ofb->cursor = NULL;
+		OMAPFBCursorFree(cursor);
+		return FALSE;
+	}
+
+	xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+	           "Hardware cursor on overlay %i through /dev/fb%i\n",
+	           cursor->overlay, cursor->fb_idx);
+
+	return TRUE;
+}
+
+void
+OMAPFBCursorCloseScreen(ScreenPtr pScreen)
+{
+	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	if (ofb->cursor == NULL)
+		return;
+
+	xf86_cursors_fini(pScreen);
+
+	OMAPFBCursorSetVisible(ofb->cursor, FALSE);
+	OMAPFBCursorFree(ofb->cursor);
+	ofb->cursor = NULL;
+}
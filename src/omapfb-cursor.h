@@ -0,0 +1,42 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#ifndef __OMAPFB_CURSOR_H__
+#define __OMAPFB_CURSOR_H__
+
+/* Sets up the hardware cursor on a spare overlay, call after the
+ * software cursor is initialized. Returns FALSE if the software cursor
+ * is what we'll be using.
+ */
+Bool OMAPFBCursorInit(ScreenPtr pScreen);
+void OMAPFBCursorCloseScreen(ScreenPtr pScreen);
+
+/* CRTC hooks */
+void OMAPFBCrtcSetCursorColors(xf86CrtcPtr crtc, int bg, int fg);
+void OMAPFBCrtcSetCursorPosition(xf86CrtcPtr crtc, int x, int y);
+void OMAPFBCrtcShowCursor(xf86CrtcPtr crtc);
+void OMAPFBCrtcHideCursor(xf86CrtcPtr crtc);
+void OMAPFBCrtcLoadCursorARGB(xf86CrtcPtr crtc, CARD32 *image);
+
+#endif /* __OMAPFB_CURSOR_H__ */
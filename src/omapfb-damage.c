@@ -0,0 +1,518 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xorg-server.h"
+#include "xf86.h"
+#include "xf86_OSlib.h"
+#include "xf86Crtc.h"
+#include "damage.h"
+
+#include "omapfb-driver.h"
+#include "omapfb-crtc.h"
+#include "omapfb-damage.h"
+#include "omapfb-utils.h"
+#include "image-format-conversions.h"
+
+/* Size of one page of the screen in the framebuffer */
+static int
+OMAPFBDamagePageSize(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	return ofb->fixed_info.line_length * pScrn->virtualY;
+}
+
+/* Is one of the DSS displays updated only on request? */
+static Bool
+OMAPFBDamageDSSManualUpdate(void)
+{
+	char value[16];
+	int i;
+
+	for (i = 0; i < OMAPFB_MAX_DISPLAYS; i++) {
+		if (read_dss_sysfs_value("display", i, "update_mode",
+		                         value, sizeof(value)) < 0)
+			continue;
+		if (atoi(value) == OMAPFB_MANUAL_UPDATE)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Works out if the display only shows what we send it. If it can do
+ * either, the kernel refreshing everything periodically is the worst
+ * option, so switch it to manual updates.
+ */
+static void
+OMAPFBDamageUpdateModeSetup(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int i, mode;
+
+	ofb->manual_update = FALSE;
+	ofb->restore_auto_update = FALSE;
+
+	if (ioctl (ofb->fd, OMAPFB_GET_UPDATE_MODE, &mode) == 0) {
+		if (mode == OMAPFB_MANUAL_UPDATE) {
+			ofb->manual_update = TRUE;
+		} else if (mode == OMAPFB_AUTO_UPDATE &&
+		           (ofb->caps.ctrl & OMAPFB_CAPS_MANUAL_UPDATE)) {
+			mode = OMAPFB_MANUAL_UPDATE;
+			if (ioctl (ofb->fd, OMAPFB_SET_UPDATE_MODE, &mode) == 0) {
+				ofb->manual_update = TRUE;
+				ofb->restore_auto_update = TRUE;
+			}
+		}
+	} else if (ofb->dss) {
+		ofb->manual_update = OMAPFBDamageDSSManualUpdate();
+	}
+
+	ofb->update_box.x1 = ofb->update_box.y1 = 0;
+	ofb->update_box.x2 = ofb->update_box.y2 = 0;
+	ofb->last_update = 0;
+
+	/* Mode sets find out for each display, until then assume they
+	 * all are like the base one
+	 */
+	for (i = 0; i < ofb->num_crtcs; i++) {
+		OMAPFBCrtcPtr ocrtc = ofb->crtcs[i]->driver_private;
+		ocrtc->manual_update = ofb->manual_update;
+	}
+
+	if (ofb->manual_update)
+		xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+		           "Manual update display, updating damage at most every %i ms\n",
+		           ofb->update_interval);
+}
+
+void
+OMAPFBDamageSetup(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int size = pScrn->virtualX * pScrn->virtualY * (pScrn->bitsPerPixel >> 3);
+
+	ofb->pages = 1;
+	ofb->front_page = 0;
+
+	if (ofb->page_flip) {
+		if (2 * size > ofb->mem_info.size) {
+			xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+			           "Not enough framebuffer memory for page flipping"
+			           " (%i needed, %i available)\n",
+			           2 * size, ofb->mem_info.size);
+		} else {
+			ofb->pages = 2;
+		}
+	}
+
+	xf86DrvMsg(pScrn->scrnIndex, X_INFO, "Page flipping %s\n",
+	           ofb->pages > 1 ? "enabled" : "disabled");
+	xf86DrvMsg(pScrn->scrnIndex, X_INFO, "Shadow framebuffer %s\n",
+	           ofb->shadow_fb ? "enabled" : "disabled");
+
+	OMAPFBDamageUpdateModeSetup(pScrn);
+}
+
+Bool
+OMAPFBDamageAllocate(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	unsigned char *shadow;
+
+	if (!ofb->shadow_fb)
+		return TRUE;
+
+	/* Same layout as the framebuffer, so the rectangles map 1:1 */
+	shadow = calloc(1, OMAPFBDamagePageSize(pScrn));
+	if (shadow == NULL) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Allocating shadow framebuffer failed\n",
+		           __FUNCTION__);
+		return FALSE;
+	}
+
+	free(ofb->shadow);
+	ofb->shadow = shadow;
+
+	/* Anything pending refers to the old layout */
+	if (ofb->damage != NULL) {
+		DamageEmpty(ofb->damage);
+		REGION_EMPTY(screenInfo.screens[pScrn->scrnIndex], &ofb->flip_damage);
+	}
+
+	return TRUE;
+}
+
+/* The page that is not being shown */
+static unsigned char *
+OMAPFBDamageBackPage(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	if (ofb->pages > 1)
+		return ofb->fb + (1 - ofb->front_page) * OMAPFBDamagePageSize(pScrn);
+
+	return ofb->fb;
+}
+
+unsigned char *
+OMAPFBDamageRenderBuffer(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	if (ofb->shadow != NULL)
+		return ofb->shadow;
+
+	return OMAPFBDamageBackPage(pScrn);
+}
+
+/* Waits until the display has picked up the new page */
+static void
+OMAPFBDamageWaitForFlip(OMAPFBPtr ofb)
+{
+	/* DSS tells us when the new configuration is in use... */
+	if (ioctl (ofb->fd, OMAPFB_WAITFORGO) == 0)
+		return;
+
+	/* ...the older driver only has a wait for vsync */
+	if (ioctl (ofb->fd, OMAPFB_VSYNC)) {
+		xf86Msg(X_ERROR, "%s: Waiting for vsync failed: %s\n",
+		        __FUNCTION__, strerror(errno));
+	}
+}
+
+/* Copies the given region between two buffers with the framebuffer layout */
+static void
+OMAPFBDamageCopyRegion(ScrnInfoPtr pScrn, RegionPtr region,
+                       unsigned char *src, unsigned char *dest)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int stride = ofb->fixed_info.line_length;
+	int bpp = pScrn->bitsPerPixel >> 3;
+	BoxPtr box = REGION_RECTS(region);
+	int n = REGION_NUM_RECTS(region);
+
+	while (n--) {
+		int offset = box->y1 * stride + box->x1 * bpp;
+
+		rect_copy((box->x2 - box->x1) * bpp, box->y2 - box->y1,
+		          stride, stride, src + offset, dest + offset);
+		box++;
+	}
+}
+
+/* Shows the back page on all CRTCs */
+static void
+OMAPFBDamageFlip(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int i;
+
+	ofb->front_page = 1 - ofb->front_page;
+	for (i = 0; i < ofb->num_crtcs; i++) {
+		xf86CrtcPtr crtc = ofb->crtcs[i];
+		if (crtc->enabled)
+			crtc->funcs->set_origin(crtc, crtc->x, crtc->y);
+	}
+
+	/* The old page can't be touched until it is off the screen */
+	OMAPFBDamageWaitForFlip(ofb);
+}
+
+/* Adds a box to what the display hasn't been sent yet */
+static void
+OMAPFBDamageAddUpdate(OMAPFBPtr ofb, BoxPtr box)
+{
+	BoxPtr u = &ofb->update_box;
+
+	if (u->x1 >= u->x2 || u->y1 >= u->y2) {
+		*u = *box;
+		return;
+	}
+
+	u->x1 = min(u->x1, box->x1);
+	u->y1 = min(u->y1, box->y1);
+	u->x2 = max(u->x2, box->x2);
+	u->y2 = max(u->y2, box->y2);
+}
+
+void
+OMAPFBDamageUpdate(ScrnInfoPtr pScrn, BoxPtr box)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int sigio;
+
+	if (!ofb->manual_update || box->x1 >= box->x2 || box->y1 >= box->y2)
+		return;
+
+	/* The cursor gets moved from the SIGIO handler. The signal also
+	 * interrupts the select the server may be sleeping in, so the
+	 * block handler runs and sends the box without more prodding.
+	 */
+	sigio = xf86BlockSIGIO();
+	OMAPFBDamageAddUpdate(ofb, box);
+	xf86UnblockSIGIO(sigio);
+}
+
+/* Sends the part of the box the CRTC shows to its display */
+static void
+OMAPFBDamageSendCrtcUpdate(OMAPFBPtr ofb, xf86CrtcPtr crtc, BoxRec box)
+{
+	OMAPFBCrtcPtr ocrtc = crtc->driver_private;
+	struct omapfb_update_window w;
+
+	if (!crtc->enabled || ocrtc->fd == -1 || !ocrtc->manual_update)
+		return;
+
+	/* The window is relative to what the CRTC shows. The rotated
+	 * layout isn't worth working out, send all of it then.
+	 */
+	if (crtc->rotation & ~RR_Rotate_0) {
+		box.x1 = box.y1 = 0;
+		box.x2 = ocrtc->state_info.xres;
+		box.y2 = ocrtc->state_info.yres;
+	} else {
+		box.x1 = max(box.x1 - crtc->x, 0);
+		box.y1 = max(box.y1 - crtc->y, 0);
+		box.x2 = min(box.x2 - crtc->x, (int)ocrtc->state_info.xres);
+		box.y2 = min(box.y2 - crtc->y, (int)ocrtc->state_info.yres);
+		if (box.x1 >= box.x2 || box.y1 >= box.y2)
+			return;
+	}
+
+	w.x = w.out_x = box.x1;
+	w.y = w.out_y = box.y1;
+	w.width = w.out_width = box.x2 - box.x1;
+	w.height = w.out_height = box.y2 - box.y1;
+	w.format = 0;
+	if (ofb->tear_sync && (ofb->caps.ctrl & OMAPFB_CAPS_TEARSYNC))
+		w.format |= OMAPFB_FORMAT_FLAG_TEARSYNC;
+
+	if (ioctl (ocrtc->fd, OMAPFB_UPDATE_WINDOW, &w)) {
+		/* Displays that refresh themselves refuse updates, which
+		 * is how we find out about those the kernel can't tell
+		 * us the update mode of
+		 */
+		if (errno == EINVAL) {
+			ocrtc->manual_update = FALSE;
+			return;
+		}
+		xf86Msg(X_ERROR, "%s: Failed to update /dev/fb%i: %s\n",
+		        __FUNCTION__, ocrtc->fb_idx, strerror(errno));
+	}
+}
+
+/* Sends the collected box to the manual update displays, unless the
+ * last update was too recent. In that case the server is woken up when
+ * it's time for the next one.
+ */
+static void
+OMAPFBDamageSendUpdate(ScrnInfoPtr pScrn, pointer pTimeout)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	CARD32 now = GetTimeInMillis();
+	CARD32 elapsed = now - ofb->last_update;
+	Bool pending, due = elapsed >= (CARD32)ofb->update_interval;
+	BoxRec box;
+	int i, sigio;
+
+	sigio = xf86BlockSIGIO();
+	box = ofb->update_box;
+	pending = box.x1 < box.x2 && box.y1 < box.y2;
+	if (pending && due) {
+		ofb->update_box.x1 = ofb->update_box.y1 = 0;
+		ofb->update_box.x2 = ofb->update_box.y2 = 0;
+	}
+	xf86UnblockSIGIO(sigio);
+
+	if (!pending)
+		return;
+
+	if (!due) {
+		AdjustWaitForDelay(pTimeout, ofb->update_interval - elapsed);
+		return;
+	}
+
+	for (i = 0; i < ofb->num_crtcs; i++)
+		OMAPFBDamageSendCrtcUpdate(ofb, ofb->crtcs[i], box);
+
+	ofb->last_update = now;
+}
+
+/* Gets the damaged parts of the screen to the display */
+static void
+OMAPFBDamageFlush(ScreenPtr pScreen, pointer pTimeout)
+{
+	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	RegionPtr region = DamageRegion(ofb->damage);
+
+	if (!REGION_NOTEMPTY(pScreen, region)) {
+		if (ofb->manual_update)
+			OMAPFBDamageSendUpdate(pScrn, pTimeout);
+		return;
+	}
+
+	if (ofb->shadow != NULL && ofb->pages > 1) {
+		/* The back page also lacks what went to the other page
+		 * the last time around
+		 */
+		REGION_UNION(pScreen, &ofb->flip_damage, &ofb->flip_damage, region);
+		OMAPFBDamageCopyRegion(pScrn, &ofb->flip_damage, ofb->shadow,
+		                       OMAPFBDamageBackPage(pScrn));
+		REGION_COPY(pScreen, &ofb->flip_damage, region);
+	} else if (ofb->shadow != NULL) {
+		OMAPFBDamageCopyRegion(pScrn, region, ofb->shadow, ofb->fb);
+	}
+
+	if (ofb->pages > 1) {
+		OMAPFBDamageFlip(pScrn);
+
+		/* Without a shadow, X renders to the page directly. Bring
+		 * it up to date and render there from now on.
+		 */
+		if (ofb->shadow == NULL) {
+			OMAPFBDamageCopyRegion(pScrn, region,
+			                       ofb->fb + ofb->front_page * OMAPFBDamagePageSize(pScrn),
+			                       OMAPFBDamageBackPage(pScrn));
+			pScreen->ModifyPixmapHeader(pScreen->GetScreenPixmap(pScreen),
+			                            -1, -1, -1, -1, -1,
+			                            OMAPFBDamageRenderBuffer(pScrn));
+		}
+	}
+
+	if (ofb->manual_update) {
+		OMAPFBDamageUpdate(pScrn, REGION_EXTENTS(pScreen, region));
+		OMAPFBDamageSendUpdate(pScrn, pTimeout);
+	}
+
+	DamageEmpty(ofb->damage);
+}
+
+static void
+OMAPFBDamageBlockHandler(int i, pointer blockData, pointer pTimeout,
+                         pointer pReadmask)
+{
+	ScreenPtr pScreen = screenInfo.screens[i];
+	OMAPFBPtr ofb = OMAPFB(xf86Screens[i]);
+
+	pScreen->BlockHandler = ofb->BlockHandler;
+	(*pScreen->BlockHandler) (i, blockData, pTimeout, pReadmask);
+	pScreen->BlockHandler = OMAPFBDamageBlockHandler;
+
+	OMAPFBDamageFlush(pScreen, pTimeout);
+}
+
+static Bool
+OMAPFBDamageCreateScreenResources(ScreenPtr pScreen)
+{
+	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	Bool ret;
+
+	pScreen->CreateScreenResources = ofb->CreateScreenResources;
+	ret = (*pScreen->CreateScreenResources) (pScreen);
+	pScreen->CreateScreenResources = OMAPFBDamageCreateScreenResources;
+
+	if (!ret)
+		return FALSE;
+
+	ofb->damage = DamageCreate(NULL, NULL, DamageReportNone, TRUE,
+	                           pScreen, pScreen);
+	if (ofb->damage == NULL) {
+		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
+		           "%s: Creating damage failed\n", __FUNCTION__);
+		return FALSE;
+	}
+
+	DamageRegister(&pScreen->GetScreenPixmap(pScreen)->drawable,
+	               ofb->damage);
+
+	return TRUE;
+}
+
+Bool
+OMAPFBDamageScreenInit(ScreenPtr pScreen)
+{
+	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	/* Nothing to track when rendering straight to a display that
+	 * refreshes itself
+	 */
+	if (ofb->pages == 1 && ofb->shadow == NULL && !ofb->manual_update)
+		return TRUE;
+
+	REGION_NULL(pScreen, &ofb->flip_damage);
+
+	ofb->CreateScreenResources = pScreen->CreateScreenResources;
+	pScreen->CreateScreenResources = OMAPFBDamageCreateScreenResources;
+	ofb->BlockHandler = pScreen->BlockHandler;
+	pScreen->BlockHandler = OMAPFBDamageBlockHandler;
+
+	return TRUE;
+}
+
+void
+OMAPFBDamageCloseScreen(ScreenPtr pScreen)
+{
+	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	if (ofb->damage != NULL) {
+		DamageUnregister(&pScreen->GetScreenPixmap(pScreen)->drawable,
+		                 ofb->damage);
+		DamageDestroy(ofb->damage);
+		ofb->damage = NULL;
+	}
+
+	free(ofb->shadow);
+	ofb->shadow = NULL;
+
+	/* Leave the display as we found it for the console */
+	if (ofb->restore_auto_update) {
+		int mode = OMAPFB_AUTO_UPDATE;
+
+		if (ioctl (ofb->fd, OMAPFB_SET_UPDATE_MODE, &mode)) {
+			xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+			           "Failed to restore auto update mode: %s\n",
+			           strerror(errno));
+		}
+		ofb->restore_auto_update = FALSE;
+	}
+
+	if (ofb->BlockHandler != NULL) {
+		REGION_UNINIT(pScreen, &ofb->flip_damage);
+		pScreen->BlockHandler = ofb->BlockHandler;
+		ofb->BlockHandler = NULL;
+	}
+	if (ofb->CreateScreenResources != NULL) {
+		pScreen->CreateScreenResources = ofb->CreateScreenResources;
+		ofb->CreateScreenResources = NULL;
+	}
+}
@@ -0,0 +1,55 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __OMAPFB_DAMAGE_H__
+#define __OMAPFB_DAMAGE_H__
+
+/*
+ * Getting what X rendered to the display: rendering to a shadow in cached
+ * memory and/or page flipping between two halves of the framebuffer, and
+ * sending updates to manual update displays, driven by damage from the
+ * block handler
+ */
+
+/* Decides how rendering reaches the display, call before the virtual
+ * resolution is set up
+ */
+void OMAPFBDamageSetup(ScrnInfoPtr pScrn);
+
+/* (Re)allocates the shadow for the current virtual resolution */
+Bool OMAPFBDamageAllocate(ScrnInfoPtr pScrn);
+
+/* Where the screen pixmap should point to */
+unsigned char *OMAPFBDamageRenderBuffer(ScrnInfoPtr pScrn);
+
+/* Queues a rectangle of the screen to be sent to manual update displays,
+ * for what damage doesn't see like the cursor and video overlays. Safe
+ * to call from the SIGIO handler.
+ */
+void OMAPFBDamageUpdate(ScrnInfoPtr pScrn, BoxPtr box);
+
+/* Wraps the screen functions we need, call after fbScreenInit */
+Bool OMAPFBDamageScreenInit(ScreenPtr pScreen);
+void OMAPFBDamageCloseScreen(ScreenPtr pScreen);
+
+#endif /* __OMAPFB_DAMAGE_H__ */
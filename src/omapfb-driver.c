@@ -37,6 +37,7 @@
 #include "xf86_OSlib.h"
 
 #include "xf86Crtc.h"
+#include "xf86RandR12.h"
 
 #include "micmap.h"
 #include "mipointer.h"
@@ -62,6 +63,8 @@
 #include "omapfb-crtc.h"
 #include "omapfb-output.h"
 #include "omapfb-utils.h"
+#include "omapfb-damage.h"
+#include "omapfb-cursor.h"
 
 #define OMAPFB_VERSION 1000
 #define OMAPFB_DRIVER_NAME "OMAPFB"
@@ -73,6 +76,7 @@ static Bool OMAPFBScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **
 static Bool OMAPFBEnterVT(int scrnIndex, int flags);
 static void OMAPFBLeaveVT(int scrnIndex, int flags);
 static Bool OMAPFBSwitchMode(int scrnIndex, DisplayModePtr mode, int flags);
+static void OMAPFBAdjustFrame(int scrnIndex, int x, int y, int flags);
 
 static Bool
 OMAPFBEnsureRec(ScrnInfoPtr pScrn)
@@ -105,11 +109,31 @@ static SymTabRec OMAPFBChipsets[] = {
 typedef enum {
 	OPTION_ACCELMETHOD,
 	OPTION_FB,
+	OPTION_PAGEFLIP,
+	OPTION_SHADOWFB,
+	OPTION_HWCURSOR,
+	OPTION_DSSFCLK,
+	OPTION_MEMORYBANDWIDTH,
+	OPTION_BLIZZARDYUV420,
+	OPTION_TEARSYNC,
+	OPTION_PIXELDOUBLE,
+	OPTION_UPDATERATE,
+	OPTION_FRAMEPACING,
 } FBDevOpts;
 
 static const OptionInfoRec OMAPFBOptions[] = {
 	{ OPTION_ACCELMETHOD,	"AccelMethod",	OPTV_STRING,	{0},	FALSE },
 	{ OPTION_FB,		"fb",		OPTV_STRING,	{0},	FALSE },
+	{ OPTION_PAGEFLIP,	"PageFlip",	OPTV_BOOLEAN,	{0},	FALSE },
+	{ OPTION_SHADOWFB,	"ShadowFB",	OPTV_BOOLEAN,	{0},	FALSE },
+	{ OPTION_HWCURSOR,	"HWCursor",	OPTV_BOOLEAN,	{0},	FALSE },
+	{ OPTION_DSSFCLK,	"DSSFclk",	OPTV_INTEGER,	{0},	FALSE },
+	{ OPTION_MEMORYBANDWIDTH, "MemoryBandwidth", OPTV_INTEGER, {0},	FALSE },
+	{ OPTION_BLIZZARDYUV420, "BlizzardYUV420", OPTV_BOOLEAN, {0},	FALSE },
+	{ OPTION_TEARSYNC,	"TearSync",	OPTV_BOOLEAN,	{0},	FALSE },
+	{ OPTION_PIXELDOUBLE,	"PixelDouble",	OPTV_BOOLEAN,	{0},	FALSE },
+	{ OPTION_UPDATERATE,	"UpdateRate",	OPTV_INTEGER,	{0},	FALSE },
+	{ OPTION_FRAMEPACING,	"FramePacing",	OPTV_BOOLEAN,	{0},	FALSE },
 	{ -1,			NULL,		OPTV_NONE,	{0},	FALSE }
 };
 
@@ -256,6 +280,7 @@ OMAPFBProbe(DriverPtr drv, int flags)
 			pScrn->PreInit       = OMAPFBPreInit;
 			pScrn->ScreenInit    = OMAPFBScreenInit;
 			pScrn->SwitchMode    = OMAPFBSwitchMode;
+			pScrn->AdjustFrame   = OMAPFBAdjustFrame;
 			pScrn->EnterVT       = OMAPFBEnterVT;
 			pScrn->LeaveVT       = OMAPFBLeaveVT;
 
@@ -288,6 +313,7 @@ OMAPFBPreInit(ScrnInfoPtr pScrn, int flags)
 	EntityInfoPtr pEnt;
 	rgb zeros = { 0, 0, 0 };
 	struct stat st;
+	int bandwidth, rate;
 
 	if (flags & PROBE_DETECT) return FALSE;
 	
@@ -303,6 +329,39 @@ OMAPFBPreInit(ScrnInfoPtr pScrn, int flags)
 	ofb = OMAPFB(pScrn);
 
 	pEnt = xf86GetEntityInfo(pScrn->entityList[0]);
+
+	/* Process the options */
+	xf86CollectOptions(pScrn, NULL);
+	ofb->options = xnfalloc(sizeof(OMAPFBOptions));
+	memcpy(ofb->options, OMAPFBOptions, sizeof(OMAPFBOptions));
+	xf86ProcessOptions(pScrn->scrnIndex, pScrn->options, ofb->options);
+
+	ofb->page_flip = xf86ReturnOptValBool(ofb->options, OPTION_PAGEFLIP, FALSE);
+	ofb->shadow_fb = xf86ReturnOptValBool(ofb->options, OPTION_SHADOWFB, FALSE);
+	ofb->hw_cursor = xf86ReturnOptValBool(ofb->options, OPTION_HWCURSOR, TRUE);
+	ofb->blizzard_yuv420 = xf86ReturnOptValBool(ofb->options, OPTION_BLIZZARDYUV420, TRUE);
+	ofb->tear_sync = xf86ReturnOptValBool(ofb->options, OPTION_TEARSYNC, TRUE);
+	ofb->pixel_double = xf86ReturnOptValBool(ofb->options, OPTION_PIXELDOUBLE, FALSE);
+	ofb->frame_pacing = xf86ReturnOptValBool(ofb->options, OPTION_FRAMEPACING, TRUE);
+
+	/* How many times a second manual update displays get refreshed at
+	 * most, zero for whenever there is something new
+	 */
+	rate = xf86ReturnOptValInt(ofb->options, OPTION_UPDATERATE, 60);
+	ofb->update_interval = rate > 0 ? 1000 / rate : 0;
+
+	/* The DSS functional clock in kHz, if it's fixed on this board */
+	dss_clock_config_init(&ofb->dss_clock,
+	                      xf86ReturnOptValInt(ofb->options, OPTION_DSSFCLK, 0));
+
+	/* Scanout bandwidth budget in MB/s, unlimited unless configured */
+	bandwidth = xf86ReturnOptValInt(ofb->options, OPTION_MEMORYBANDWIDTH, 0);
+	if (bandwidth < 0)
+		bandwidth = 0;
+	bw_budget_init(&ofb->bandwidth, 1000UL * bandwidth);
+	if (bandwidth > 0)
+		xf86DrvMsg(pScrn->scrnIndex, X_CONFIG,
+		           "Scanout bandwidth limited to %i MB/s\n", bandwidth);
 	
 	/* Open the device node */
 	ofb->fd = open(ofb->fb_path, O_RDWR, 0);
@@ -411,6 +470,10 @@ OMAPFBPreInit(ScrnInfoPtr pScrn, int flags)
 
 	pScrn->modes = NULL;
 
+	/* The overlay pool decides how many CRTCs we can have */
+	if (ofb->dss)
+		ofb->ovlPool = overlayPoolInit(pScrn);
+
 	OMAPFBCRTCInit(pScrn);
 
 	if (ofb->dss) {
@@ -426,7 +489,7 @@ OMAPFBPreInit(ScrnInfoPtr pScrn, int flags)
 	}
 
 	pScrn->currentMode = pScrn->modes;
-	ofb->crtc->mode = *pScrn->currentMode;
+	ofb->crtcs[0]->mode = *pScrn->currentMode;
 
 
 	/* Disable outputs that are not used */
@@ -444,27 +507,38 @@ static void
 OMAPFBXvScreenInit(ScreenPtr pScreen)
 {
 	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
+	OMAPFBPtr ofb = OMAPFB(pScrn);
 	XF86VideoAdaptorPtr *ptr = NULL;
 	XF86VideoAdaptorPtr *omap_adaptors = NULL;
+	XF86VideoAdaptorPtr blit;
 	int on = 0;
 
 	int n = xf86XVListGenericAdaptors(pScrn, &ptr);
 
 	/* Get the omap adaptors */
-	on = OMAPFBXVInit(pScrn, &omap_adaptors);
+	/* FIXME: Currently dss & the XV overlay do not co-exist */
+	if (!ofb->dss)
+		on = OMAPFBXVInit(pScrn, &omap_adaptors);
+
+	/* ...and the one that works without the overlay */
+	blit = OMAPFBXVBlitInit(pScrn);
 
 	/* Merge the adaptor lists */
-	if (n > 0 || on > 0) {
+	if (on > 0 || blit != NULL) {
 		int i;
 		XF86VideoAdaptorPtr *generic_adaptors = ptr;
-		ptr = malloc((n + on) * sizeof(XF86VideoAdaptorPtr));
+		ptr = malloc((n + on + 1) * sizeof(XF86VideoAdaptorPtr));
+		if (ptr == NULL)
+			return;
 		for (i = 0; i < n; i++) {
 			ptr[i] = generic_adaptors[i];
 		}
-		for (i = n; i < on; i++) {
-			ptr[i] = omap_adaptors[i-n];
+		for (i = 0; i < on; i++) {
+			ptr[n + i] = omap_adaptors[i];
 		}
 		n = n + on;
+		if (blit != NULL)
+			ptr[n++] = blit;
 	}
 
 	if (n == 0 || !xf86XVScreenInit(pScreen, ptr, n)) {
@@ -480,6 +554,9 @@ OMAPFBCloseScreen(int scrnIndex, ScreenPtr pScreen)
 	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
 	OMAPFBPtr ofb = OMAPFB(pScrn);
 
+	OMAPFBCursorCloseScreen(pScreen);
+	OMAPFBDamageCloseScreen(pScreen);
+
 	munmap(ofb->fb, ofb->mem_info.size);
 
 	pScreen->CloseScreen = ofb->CloseScreen;
@@ -492,6 +569,7 @@ OMAPFBScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **argv)
 {
 	ScrnInfoPtr pScrn = xf86Screens[pScreen->myNum];
 	OMAPFBPtr ofb = OMAPFB(pScrn);
+	Bool ok;
 
 	ofb->CloseScreen = pScreen->CloseScreen;
 	pScreen->CloseScreen = OMAPFBCloseScreen;
@@ -505,6 +583,31 @@ OMAPFBScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **argv)
 		return FALSE;
 	}
 
+	/* Decide if we flip pages, that affects the framebuffer size */
+	OMAPFBDamageSetup(pScrn);
+
+	/* The screen might be larger than the framebuffer currently is,
+	 * to fit multiple CRTCs side by side
+	 */
+	ok = OMAPFBSetVirtualSize(pScrn, pScrn->virtualX, pScrn->virtualY);
+	if (!ok && ofb->pages > 1) {
+		xf86DrvMsg(scrnIndex, X_WARNING,
+		           "Can't fit two pages, disabling page flipping\n");
+		ofb->pages = 1;
+		ok = OMAPFBSetVirtualSize(pScrn, pScrn->virtualX, pScrn->virtualY);
+	}
+	if (!ok) {
+		xf86DrvMsg(scrnIndex, X_WARNING,
+		           "Falling back to %ix%i virtual resolution\n",
+		           ofb->state_info.xres_virtual,
+		           ofb->state_info.yres_virtual);
+		pScrn->virtualX = ofb->state_info.xres_virtual;
+		pScrn->virtualY = ofb->state_info.yres_virtual;
+	}
+
+	if (!OMAPFBDamageAllocate(pScrn))
+		return FALSE;
+
 	/* Reset visuals */
 	miClearVisualTypes();
 
@@ -527,7 +630,7 @@ OMAPFBScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **argv)
 	xf86LoadSubModule(pScrn, "fb");
 
 	/* Initialize fallbacks for the screen */
-	if (!fbScreenInit(pScreen, ofb->fb, pScrn->virtualX,
+	if (!fbScreenInit(pScreen, OMAPFBDamageRenderBuffer(pScrn), pScrn->virtualX,
 	                  pScrn->virtualY, pScrn->xDpi,
 	                  pScrn->yDpi, pScrn->displayWidth,
 	                  pScrn->bitsPerPixel)) {
@@ -555,6 +658,12 @@ OMAPFBScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **argv)
 		xf86DrvMsg(scrnIndex, X_ERROR, "fbPictureInit failed\n");
 		return FALSE;
 	}
+
+	/* Track what gets rendered, for flipping */
+	if (!OMAPFBDamageScreenInit(pScreen)) {
+		xf86DrvMsg(scrnIndex, X_ERROR, "Damage tracking setup failed\n");
+		return FALSE;
+	}
 	
 	/* Setup default colors */
 	xf86SetBlackWhitePixels(pScreen);
@@ -562,6 +671,11 @@ OMAPFBScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **argv)
 	/* Initialize software cursor */
 	miDCInitialize(pScreen, xf86GetPointerScreenFuncs());
 
+	/* ...which is only a fallback if we can spare an overlay */
+	if (ofb->hw_cursor && !OMAPFBCursorInit(pScreen)) {
+		xf86DrvMsg(scrnIndex, X_INFO, "Using software cursor\n");
+	}
+
 	/* Initialize default colormap */
 	if (!miCreateDefColormap(pScreen)) {
 		xf86DrvMsg(scrnIndex, X_ERROR,
@@ -615,19 +729,39 @@ OMAPFBScreenInit(int scrnIndex, ScreenPtr pScreen, int argc, char **argv)
 #endif
 
 	/* Initialize XVideo support */
-	/* FIXME: Currently dss & XV do not co-exist */
-	if (!ofb->dss)
-		OMAPFBXvScreenInit(pScreen);
+	OMAPFBXvScreenInit(pScreen);
 
 	/* Initialize RANDR support */
 	xf86CrtcScreenInit(pScreen);
 
+	/* Only offer the rotations the hardware does, not the shadow ones */
+	xf86RandR12SetRotations(pScreen, OMAPFBCrtcRotations(pScrn));
+
 	return TRUE;
 }
 
 static Bool OMAPFBSwitchMode(int scrnIndex, DisplayModePtr mode, int flags)
 {
-	return xf86SetSingleMode (xf86Screens[scrnIndex], mode, RR_Rotate_0);
+	ScrnInfoPtr pScrn = xf86Screens[scrnIndex];
+	xf86CrtcConfigPtr config = XF86_CRTC_CONFIG_PTR(pScrn);
+	xf86CrtcPtr crtc = config->output[config->compat_output]->crtc;
+
+	/* Keep the display the way it's turned */
+	return xf86SetSingleMode (pScrn, mode,
+	                          crtc != NULL ? crtc->rotation : RR_Rotate_0);
+}
+
+static void
+OMAPFBAdjustFrame(int scrnIndex, int x, int y, int flags)
+{
+	ScrnInfoPtr pScrn = xf86Screens[scrnIndex];
+	xf86CrtcConfigPtr config = XF86_CRTC_CONFIG_PTR(pScrn);
+	xf86OutputPtr output = config->output[config->compat_output];
+	xf86CrtcPtr crtc = output->crtc;
+
+	/* Viewport moves are just a pan of the framebuffer */
+	if (crtc != NULL && crtc->enabled)
+		xf86CrtcSetOrigin(crtc, x, y);
 }
 
 void
@@ -659,7 +793,7 @@ OMAPFBPrintCapabilities(ScrnInfoPtr pScrn,
 	           );
 
 #define MAKE_STR(f) #f
-#define PRINT_FORMAT(f) (caps->plane_color & OMAPFB_COLOR_##f) ? MAKE_STR(\t##f\n) : ""
+#define PRINT_FORMAT(f) (caps->plane_color & (1 << OMAPFB_COLOR_##f)) ? MAKE_STR(\t##f\n) : ""
 
 	xf86DrvMsg(pScrn->scrnIndex, X_INFO,
 	           "%s supports the following image formats:\n%s%s%s%s%s%s%s%s%s",
@@ -30,18 +30,27 @@
 #include "xf86xv.h"
 #include "xf86_OSlib.h"
 #include "xf86Crtc.h"
+#include "damage.h"
 
 #include <linux/fb.h>
 #include "omapfb.h"
 
 #define OMAPFB_MAX_DISPLAYS 10
 
+/* Bandwidth budget consumers: the CRTCs by index, then the video plane */
+#define OMAPFB_BW_VIDEO OMAPFB_MAX_DISPLAYS
+
 #include "omapfb-overlay-pool.h"
+#include "omapfb-dss-clock.h"
+#include "omapfb-bandwidth.h"
+#include "omapfb-xv-queue.h"
 
 /* XV port */
 typedef struct {
 	int fd;
 	unsigned char *fb;
+	/* How much of the plane memory is mapped at fb */
+	int mapped_size;
 	/* Non-changeable hardware info */
 	struct fb_fix_screeninfo fixed_info;
 	/* Per-mode state info */
@@ -51,11 +60,119 @@ typedef struct {
 	struct omapfb_plane_info plane_info;
 	struct omapfb_update_window update_window;
 	RegionRec current_clip;
+	/* Source shrink factor applied in software before the scaler */
+	int decimate;
+	/* Can the plane scan out planar YUV420 as it is? */
+	Bool planar;
+	/* Color format the plane is set up for */
+	enum omapfb_color_format format;
+	/* Frames are converted into one page of the plane memory while the
+	 * controller still transfers the other one
+	 */
+	int pages;
+	int front_page;
+	int page_height;
+	int page_size;
+	/* Plane y offset for the clipping, without the page */
+	int clip_yoffset;
+	/* Has an update been issued that we haven't synced with yet? */
+	Bool update_pending;
+	/* Paces the pages to the display, NULL if they aren't flipped */
+	OMAPXVQueuePtr queue;
+	/* Updates can wait for the panel's tearing effect signal, and
+	 * currently do if tearsync_active is set
+	 */
+	Bool tearsync;
+	Bool tearsync_active;
+	/* Smoothed time between frames in ms, for the tearsync policy */
+	CARD32 last_frame;
+	int frame_interval;
+	/* Port attributes */
+	INT32 colorkey;
+	Bool pixel_double;
+	/* Field of interlaced video to show, 1 for top and 2 for bottom,
+	 * 0 for the whole frame
+	 */
+	int field;
+	/* The field the plane is set up to show, which is 0 when the
+	 * plane scans out planar YUV420
+	 */
+	int shown_field;
+	/* What the adaptor lists, the rest are refused */
+	XF86AttributePtr attributes;
+	int n_attributes;
+	/* Is the controller currently doubling the video? */
+	Bool doubled;
 } OMAPFBPortRec, *OMAPFBPortPtr;
 
+/* Per-CRTC state, each CRTC scans out through its own framebuffer device */
+typedef struct {
+	int fd;
+	/* Index of the framebuffer device (/dev/fbX) */
+	int fb_idx;
+	struct fb_var_screeninfo state_info;
+	/* What the last mode set asked for, so that repeating it can be
+	 * skipped. Only valid when committed_valid is set.
+	 */
+	struct fb_var_screeninfo committed;
+	Bool committed_valid;
+	/* The overlay setup as last applied, so that repeating it can be
+	 * skipped too. Only valid when plane_valid is set.
+	 */
+	struct omapfb_plane_info plane;
+	Bool plane_valid;
+	/* Last cursor position we were given */
+	int cursor_x;
+	int cursor_y;
+	/* Gamma ramps as last programmed, 8 bits per entry */
+	int gamma_size;
+	CARD8 gamma[3][256];
+	Bool gamma_unsupported;
+	/* Does the display only show the updates sent to it? */
+	Bool manual_update;
+} OMAPFBCrtcRec, *OMAPFBCrtcPtr;
+
+/* Hardware cursor, shown through an overlay of its own. The framebuffer
+ * holds OMAPFB_CURSOR_SLOTS images with transparent padding around them,
+ * so that the overlay can be kept on the screen at the edges by panning.
+ */
+#define OMAPFB_CURSOR_SIZE 64
+#define OMAPFB_CURSOR_SLOTS 4
+
+typedef struct {
+	int fd;
+	int fb_idx;
+	int overlay;
+	unsigned char *mem;
+	int mem_size;
+	int stride;
+
+	/* CRTC the overlay is connected to, NULL if none yet */
+	xf86CrtcPtr crtc;
+	Bool visible;
+	struct omapfb_plane_info plane_info;
+	struct fb_var_screeninfo state_info;
+
+	/* Images uploaded to the slots, newest in current_slot */
+	int current_slot;
+	CARD32 hash[OMAPFB_CURSOR_SLOTS];
+	CARD32 *image[OMAPFB_CURSOR_SLOTS];
+} OMAPFBCursorRec, *OMAPFBCursorPtr;
+
+/* Raw EDID as last read for an output, the interpreted copy lives in
+ * the output's MonInfo
+ */
+typedef struct {
+	unsigned char *raw;
+	int len;
+	CARD32 checksum;
+} OMAPFBEDIDCacheRec, *OMAPFBEDIDCachePtr;
+
 typedef struct {
 	int fd;
 	unsigned char *fb;
+	/* How much of the plane memory is mapped at fb */
+	int mapped_size;
 	/* Non-changeable hardware info */
 	struct fb_fix_screeninfo fixed_info;
 	/* Per-mode state info */
@@ -78,11 +195,62 @@ typedef struct {
 
 	ExaDriverPtr exa;
 
-	xf86CrtcPtr crtc;
+	xf86CrtcPtr crtcs[OMAPFB_MAX_DISPLAYS];
+	int num_crtcs;
 	xf86OutputPtr outputs[OMAPFB_MAX_DISPLAYS];
 	char timings[OMAPFB_MAX_DISPLAYS][64];
+	OMAPFBEDIDCacheRec edid[OMAPFB_MAX_DISPLAYS];
 
 	OverlayPoolPtr ovlPool;
+
+	/* What the DSS can clock, for mode validation */
+	struct dss_clock_config dss_clock;
+	/* Memory bandwidth the planes may use */
+	struct bw_budget bandwidth;
+
+	OptionInfoPtr options;
+
+	/* Page flipping: the screen is this many pages tall in the
+	 * framebuffer, and we render to the one not shown
+	 */
+	Bool page_flip;
+	int pages;
+	int front_page;
+
+	/* Shadow framebuffer: X renders to cached memory and the damage
+	 * is copied to the framebuffer from the block handler
+	 */
+	Bool shadow_fb;
+	unsigned char *shadow;
+	/* What the back page is missing from the previous flip */
+	RegionRec flip_damage;
+
+	/* Manual update displays only show what we send them. Damage and
+	 * overlay changes are collected into update_box (in screen
+	 * coordinates) and sent at most every update_interval ms.
+	 */
+	Bool manual_update;
+	/* Did we switch the display from auto update? */
+	Bool restore_auto_update;
+	int update_interval;
+	CARD32 last_update;
+	BoxRec update_box;
+
+	Bool hw_cursor;
+	OMAPFBCursorPtr cursor;
+
+	/* Send planar video to Blizzard in its own 12bpp YUV420 format */
+	Bool blizzard_yuv420;
+	/* Sync manual updates to the panel's tearing effect signal */
+	Bool tear_sync;
+	/* Default for XV_PIXEL_DOUBLE */
+	Bool pixel_double;
+	/* Show video frames at display refreshes instead of right away */
+	Bool frame_pacing;
+
+	DamagePtr damage;
+	CreateScreenResourcesProcPtr CreateScreenResources;
+	ScreenBlockHandlerProcPtr BlockHandler;
 } OMAPFBRec, *OMAPFBPtr;
 
 #define OMAPFB(p) ((OMAPFBPtr)((p)->driverPrivate))
@@ -93,6 +261,10 @@ void OMAPFBPrintCapabilities(ScrnInfoPtr pScrn,
 
 Bool OMAPFBSetupExa(OMAPFBPtr ofb);
 int OMAPFBXVInit (ScrnInfoPtr pScrn, XF86VideoAdaptorPtr **omap_adaptors);
+/* Adaptor that scales and converts video in software into the screen,
+ * NULL if it can't draw to the screen format
+ */
+XF86VideoAdaptorPtr OMAPFBXVBlitInit (ScrnInfoPtr pScrn);
 
 #endif /* __OMAPFB_DRIVER_H__ */
 
@@ -0,0 +1,257 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "omapfb-dss-clock.h"
+
+/* Are we on an OMAP34xx/35xx/36xx/37xx? Newer kernels have the SoC
+ * family in sysfs, older ones only the board name in cpuinfo.
+ */
+static int
+dss_clock_soc_is_omap3(void)
+{
+	char line[256];
+	int found = 0;
+	FILE *f;
+
+	f = fopen("/sys/devices/soc0/family", "r");
+	if (f != NULL) {
+		if (fgets(line, sizeof(line), f) != NULL)
+			found = strncmp(line, "OMAP3", 5) == 0;
+		fclose(f);
+		return found;
+	}
+
+	f = fopen("/proc/cpuinfo", "r");
+	if (f == NULL)
+		return 0;
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (strncmp(line, "Hardware", 8) == 0) {
+			found = strstr(line, "OMAP3") != NULL
+			     || strstr(line, "OMAP34") != NULL
+			     || strstr(line, "OMAP36") != NULL;
+			break;
+		}
+	}
+	fclose(f);
+
+	return found;
+}
+
+void
+dss_clock_config_init(struct dss_clock_config *cfg, int fck)
+{
+	/* A fixed fck is board knowledge, trust it */
+	cfg->enabled = fck > 0 || dss_clock_soc_is_omap3();
+
+	/* DSS1_ALWON_FCLK comes from DPLL4 M4X2 on OMAP34xx */
+	cfg->fck = fck > 0 ? fck : 0;
+	cfg->dpll = 864000;
+	cfg->fck_div_min = 1;
+	cfg->fck_div_max = 16;
+	cfg->fck_max = 173000;
+
+	/* PCD of 1 is not allowed for LCD output on OMAP3 */
+	cfg->lck_min = 1;
+	cfg->lck_max = 255;
+	cfg->pcd_min = 2;
+	cfg->pcd_max = 255;
+	cfg->tolerance = 20;
+
+	/* DISPC_SIZE_LCD and DISPC_TIMING_H/V field widths. Horizontal
+	 * values and the vertical sync width are programmed minus one.
+	 */
+	cfg->max_width = 2048;
+	cfg->max_height = 2048;
+	cfg->hsw_min = 1;
+	cfg->hsw_max = 256;
+	cfg->hfp_min = 1;
+	cfg->hfp_max = 4096;
+	cfg->hbp_min = 1;
+	cfg->hbp_max = 4096;
+	cfg->vsw_min = 1;
+	cfg->vsw_max = 256;
+	cfg->vfp_min = 0;
+	cfg->vfp_max = 4095;
+	cfg->vbp_min = 0;
+	cfg->vbp_max = 4095;
+}
+
+/* Functional clock for the given divider, 0 if it is not usable */
+static int
+dss_clock_fck(const struct dss_clock_config *cfg, int fck_div)
+{
+	int fck;
+
+	if (cfg->fck > 0)
+		return fck_div == cfg->fck_div_min ? cfg->fck : 0;
+
+	fck = cfg->dpll / fck_div;
+
+	return fck <= cfg->fck_max ? fck : 0;
+}
+
+/* Best LCK and PCD for one functional clock, returns the error in kHz */
+static int
+dss_clock_find_lck_pcd(const struct dss_clock_config *cfg, int fck,
+                       int pixel_clock, struct dss_clock_divisors *div)
+{
+	int lck, best_err = -1;
+
+	for (lck = cfg->lck_min; lck <= cfg->lck_max; lck++) {
+		int pcd, clock, err;
+
+		/* The nearest pixel clock divider for this LCK */
+		pcd = (fck + lck * pixel_clock / 2) / (lck * pixel_clock);
+		if (pcd < cfg->pcd_min)
+			pcd = cfg->pcd_min;
+		if (pcd > cfg->pcd_max)
+			pcd = cfg->pcd_max;
+
+		clock = fck / (lck * pcd);
+		err = abs(clock - pixel_clock);
+
+		if (best_err == -1 || err < best_err) {
+			best_err = err;
+			div->fck = fck;
+			div->lck = lck;
+			div->pcd = pcd;
+			div->pixel_clock = clock;
+			if (err == 0)
+				break;
+		}
+
+		/* Larger LCKs only get further from high clocks */
+		if (fck / lck < pixel_clock * cfg->pcd_min)
+			break;
+	}
+
+	return best_err;
+}
+
+/* Highest functional clock we can have */
+static int
+dss_clock_max_fck(const struct dss_clock_config *cfg)
+{
+	int fck_div;
+
+	for (fck_div = cfg->fck_div_min; fck_div <= cfg->fck_div_max; fck_div++) {
+		int fck = dss_clock_fck(cfg, fck_div);
+		if (fck > 0)
+			return fck;
+	}
+
+	return 0;
+}
+
+/* Lowest functional clock we can have */
+static int
+dss_clock_min_fck(const struct dss_clock_config *cfg)
+{
+	int fck_div;
+
+	for (fck_div = cfg->fck_div_max; fck_div >= cfg->fck_div_min; fck_div--) {
+		int fck = dss_clock_fck(cfg, fck_div);
+		if (fck > 0)
+			return fck;
+	}
+
+	return 0;
+}
+
+int
+dss_clock_find_divisors(const struct dss_clock_config *cfg, int pixel_clock,
+                        struct dss_clock_divisors *div)
+{
+	struct dss_clock_divisors d;
+	int fck_div, best_err = -1;
+
+	if (pixel_clock <= 0)
+		return -1;
+
+	for (fck_div = cfg->fck_div_min; fck_div <= cfg->fck_div_max; fck_div++) {
+		int err, fck = dss_clock_fck(cfg, fck_div);
+
+		if (fck == 0)
+			continue;
+
+		err = dss_clock_find_lck_pcd(cfg, fck, pixel_clock, &d);
+		if (err != -1 && (best_err == -1 || err < best_err)) {
+			best_err = err;
+			*div = d;
+			if (err == 0)
+				break;
+		}
+	}
+
+	if (best_err == -1)
+		return -1;
+	if ((long long)best_err * 1000 > (long long)cfg->tolerance * pixel_clock)
+		return 1;
+
+	return 0;
+}
+
+enum dss_mode_status
+dss_check_timings(const struct dss_clock_config *cfg,
+                  const struct dss_timings *t,
+                  struct dss_clock_divisors *div)
+{
+	struct dss_clock_divisors d;
+	long long max_clock = dss_clock_max_fck(cfg) / (cfg->lck_min * cfg->pcd_min);
+	long long min_clock = dss_clock_min_fck(cfg) / (cfg->lck_max * cfg->pcd_max);
+	long long slack;
+	int ret;
+
+	if (t->x_res < 1 || t->x_res > cfg->max_width
+	 || t->hsw < cfg->hsw_min || t->hsw > cfg->hsw_max
+	 || t->hfp < cfg->hfp_min || t->hfp > cfg->hfp_max
+	 || t->hbp < cfg->hbp_min || t->hbp > cfg->hbp_max)
+		return DSS_MODE_H_ILLEGAL;
+
+	if (t->y_res < 1 || t->y_res > cfg->max_height
+	 || t->vsw < cfg->vsw_min || t->vsw > cfg->vsw_max
+	 || t->vfp < cfg->vfp_min || t->vfp > cfg->vfp_max
+	 || t->vbp < cfg->vbp_min || t->vbp > cfg->vbp_max)
+		return DSS_MODE_V_ILLEGAL;
+
+	slack = (long long)t->pixel_clock * cfg->tolerance / 1000;
+	if (t->pixel_clock - slack > max_clock)
+		return DSS_MODE_CLOCK_HIGH;
+	if (t->pixel_clock <= 0 || t->pixel_clock + slack < min_clock)
+		return DSS_MODE_CLOCK_LOW;
+
+	ret = dss_clock_find_divisors(cfg, t->pixel_clock, &d);
+	if (ret < 0)
+		return DSS_MODE_CLOCK_LOW;
+
+	if (div != NULL)
+		*div = d;
+
+	return ret == 0 ? DSS_MODE_OK : DSS_MODE_CLOCK_INEXACT;
+}
@@ -0,0 +1,110 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * Model of the DSS (DISPC) pixel clock generation and timing limits,
+ * for checking modes before trying them on the hardware.
+ *
+ * This is plain C without X server dependencies, so that it can be built
+ * and exercised on its own.
+ */
+
+#ifndef __OMAPFB_DSS_CLOCK_H__
+#define __OMAPFB_DSS_CLOCK_H__
+
+struct dss_clock_config {
+	/* Is the model known to match the hardware? Modes aren't checked
+	 * against it otherwise.
+	 */
+	int enabled;
+	/* DISPC functional clock in kHz if it is fixed, 0 if the kernel
+	 * may pick it as dpll / fck_div, up to fck_max
+	 */
+	int fck;
+	int dpll;
+	int fck_div_min, fck_div_max;
+	int fck_max;
+	/* The pixel clock is fck / lck / pcd */
+	int lck_min, lck_max;
+	int pcd_min, pcd_max;
+	/* How far off the pixel clock may be, in 1/1000ths */
+	int tolerance;
+
+	/* Timing register limits */
+	int max_width, max_height;
+	int hsw_min, hsw_max;
+	int hfp_min, hfp_max;
+	int hbp_min, hbp_max;
+	int vsw_min, vsw_max;
+	int vfp_min, vfp_max;
+	int vbp_min, vbp_max;
+};
+
+/* Same layout as the omapdss sysfs timings, clock in kHz */
+struct dss_timings {
+	int pixel_clock;
+	int x_res, hfp, hsw, hbp;
+	int y_res, vfp, vsw, vbp;
+};
+
+struct dss_clock_divisors {
+	int fck;
+	int lck;
+	int pcd;
+	/* What we'd actually get, kHz */
+	int pixel_clock;
+};
+
+enum dss_mode_status {
+	DSS_MODE_OK = 0,
+	/* Works, with the nearest pixel clock we can make */
+	DSS_MODE_CLOCK_INEXACT,
+	DSS_MODE_CLOCK_HIGH,
+	DSS_MODE_CLOCK_LOW,
+	DSS_MODE_H_ILLEGAL,
+	DSS_MODE_V_ILLEGAL,
+};
+
+/* Sets up the OMAP3 limits. fck is the functional clock in kHz, or 0 to
+ * let the model pick it from DPLL4 like the kernel does. The model is only
+ * enabled on OMAP3, or when fck is given.
+ */
+void dss_clock_config_init(struct dss_clock_config *cfg, int fck);
+
+/* Finds the dividers that get closest to pixel_clock (kHz). Returns 0 if
+ * the result is within tolerance, 1 if it's only the nearest we can do and
+ * -1 if there's nothing.
+ */
+int dss_clock_find_divisors(const struct dss_clock_config *cfg, int pixel_clock,
+                            struct dss_clock_divisors *div);
+
+/* Checks that the hardware can produce the timings. Only clocks clearly
+ * out of range are refused, like the kernel we go with the nearest one
+ * otherwise. div may be NULL.
+ */
+enum dss_mode_status dss_check_timings(const struct dss_clock_config *cfg,
+                                       const struct dss_timings *t,
+                                       struct dss_clock_divisors *div);
+
+#endif /* __OMAPFB_DSS_CLOCK_H__ */
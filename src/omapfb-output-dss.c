@@ -28,6 +28,7 @@
 #include "xorg-server.h"
 #include "xf86.h"
 #include "xf86Crtc.h"
+#include "xf86DDC.h"
 
 #ifdef HAVE_XEXTPROTO_71
 #include <X11/extensions/dpmsconst.h>
@@ -37,9 +38,14 @@
 #endif
 
 #include "omapfb-driver.h"
+#include "omapfb-crtc.h"
 #include "omapfb-output.h"
 #include "omapfb-utils.h"
 #include "omapfb-overlay-pool.h"
+#include "omapfb-dss-clock.h"
+
+/* Size of a single EDID block */
+#define EDID_BLOCK_LEN 128
 
 /*** Utility functions */
 
@@ -109,6 +115,108 @@ OMAPFBDSSOutputReadValue(xf86OutputPtr output,
 	return rc;
 }
 
+/* Sum over the whole blob, seeded with the length so that truncated reads
+ * of an otherwise identical EDID don't match
+ */
+static CARD32
+OMAPFBDSSOutputEDIDChecksum(const unsigned char *edid, int len)
+{
+	int i;
+	CARD32 a = 1, b = len;
+
+	for (i = 0; i < len; i++) {
+		a = (a + edid[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return (b << 16) | a;
+}
+
+/* Reads the EDID of the display (if the panel driver exposes one) and
+ * updates the output's monitor info when it has changed
+ */
+static void
+OMAPFBDSSOutputUpdateEDID(xf86OutputPtr output)
+{
+	static const unsigned char header[8] = {
+		0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00
+	};
+	unsigned char buf[EDID_BLOCK_LEN * 4];
+	OMAPFBPtr ofb = OMAPFB(output->scrn);
+	OMAPFBEDIDCachePtr cache;
+	xf86MonPtr mon;
+	unsigned char *raw;
+	CARD32 checksum;
+	int idx = OMAPFBDSSOutputIndex(output);
+	int len;
+
+	if (idx < 0)
+		return;
+	cache = &ofb->edid[idx];
+
+	len = read_dss_sysfs_value("display", idx, "edid",
+	                           (char *)buf, sizeof(buf));
+	if (len < EDID_BLOCK_LEN || memcmp(buf, header, 8) != 0) {
+		/* No EDID (anymore), forget what we had */
+		if (cache->raw != NULL) {
+			xf86OutputSetEDID(output, NULL);
+			free(cache->raw);
+			cache->raw = NULL;
+			cache->len = 0;
+		}
+		return;
+	}
+
+	/* Only use complete blocks, and only as many as the base block says */
+	len -= len % EDID_BLOCK_LEN;
+	if (len > (buf[126] + 1) * EDID_BLOCK_LEN)
+		len = (buf[126] + 1) * EDID_BLOCK_LEN;
+
+	checksum = OMAPFBDSSOutputEDIDChecksum(buf, len);
+	if (cache->raw != NULL && output->MonInfo != NULL
+	 && cache->len == len && cache->checksum == checksum)
+		return;
+
+	/* The monitor info keeps a pointer to the raw data, so it needs to
+	 * stay around as long as the monitor info does
+	 */
+	raw = malloc(len);
+	if (raw == NULL)
+		return;
+	memcpy(raw, buf, len);
+
+	mon = xf86InterpretEEDID(output->scrn->scrnIndex, raw);
+	if (mon == NULL) {
+		xf86DrvMsg(output->scrn->scrnIndex, X_WARNING,
+		           "%s: invalid EDID for %s\n", __FUNCTION__, output->name);
+		free(raw);
+		return;
+	}
+
+	xf86DrvMsg(output->scrn->scrnIndex, X_INFO,
+	           "EDID for output %s:\n", output->name);
+	xf86PrintEDID(mon);
+
+	/* This frees the old monitor info */
+	xf86OutputSetEDID(output, mon);
+
+	free(cache->raw);
+	cache->raw = raw;
+	cache->len = len;
+	cache->checksum = checksum;
+}
+
+/* Picks an overlay that can do what the CRTC needs */
+static int
+OMAPFBDSSOutputGetOverlay (xf86OutputPtr output)
+{
+	OMAPFBPtr ofb = OMAPFB(output->scrn);
+
+	if (output->crtc != NULL && OMAPFBCrtcScaled(output->crtc))
+		return overlayPoolGetFreeScalingOverlay(ofb->ovlPool);
+
+	return overlayPoolGetFreeOverlay(ofb->ovlPool);
+}
 
 static void
 OMAPFBDSSOutputDPMS (xf86OutputPtr output, int mode)
@@ -116,10 +224,12 @@ OMAPFBDSSOutputDPMS (xf86OutputPtr output, int mode)
 	OMAPFBPtr ofb = OMAPFB(output->scrn);
 	switch (mode) {
 		case DPMSModeOn:
-			if (!overlayPoolDisplayConnected(ofb->ovlPool, output->name))
+			if (!overlayPoolDisplayConnected(ofb->ovlPool, output->name)
+			 && output->crtc != NULL)
 			{
-				int ovl = overlayPoolGetFreeOverlay(ofb->ovlPool);
-				overlayPoolConnect(ofb->ovlPool, 0, ovl, output->name);
+				OMAPFBCrtcPtr ocrtc = output->crtc->driver_private;
+				int ovl = OMAPFBDSSOutputGetOverlay(output);
+				overlayPoolConnect(ofb->ovlPool, ocrtc->fb_idx, ovl, output->name);
 				overlayPoolApplyConnections(ofb->ovlPool);
 			}
 			OMAPFBDSSOutputWriteValue(output, "enabled", "1");
@@ -147,8 +257,76 @@ static int
 OMAPFBDSSOutputValidateMode (xf86OutputPtr output,
                           DisplayModePtr mode)
 {
-	/* We accept pretty much any mode */
-	return MODE_OK;
+	OMAPFBPtr ofb = OMAPFB(output->scrn);
+	int idx = OMAPFBDSSOutputIndex(output);
+	struct dss_timings t;
+	struct dss_clock_divisors div;
+	char timings[64];
+	int status;
+
+	status = OMAPFBOutputValidateMemory(output, mode);
+	if (status != MODE_OK)
+		return status;
+
+	status = OMAPFBOutputValidateBandwidth(output, mode);
+	if (status != MODE_OK)
+		return status;
+
+	/* Whatever the kernel has set up already works, it may be using
+	 * a clock source that we don't know about
+	 */
+	mode_to_timings(mode, timings, 64);
+	if (idx >= 0 && strcmp(timings, ofb->timings[idx]) == 0)
+		return MODE_OK;
+
+	/* TV out runs off its own fixed clock and timings */
+	if (strncmp(output->name, "tv", 2) == 0)
+		return MODE_OK;
+
+	if (mode->Flags & V_INTERLACE)
+		return MODE_NO_INTERLACE;
+	if (mode->Flags & V_DBLSCAN)
+		return MODE_NO_DBLESCAN;
+
+	/* The model is of the OMAP3 DISPC clocked from the DSS fck. HDMI
+	 * and DSI have PLLs of their own, and on other SoCs we don't know
+	 * the limits.
+	 */
+	if (!ofb->dss_clock.enabled
+	 || strncmp(output->name, "hdmi", 4) == 0
+	 || strncmp(output->name, "dsi", 3) == 0)
+		return MODE_OK;
+
+	t.pixel_clock = mode->Clock;
+	t.x_res = mode->HDisplay;
+	t.hfp = mode->HSyncStart - mode->HDisplay;
+	t.hsw = mode->HSyncEnd - mode->HSyncStart;
+	t.hbp = mode->HTotal - mode->HSyncEnd;
+	t.y_res = mode->VDisplay;
+	t.vfp = mode->VSyncStart - mode->VDisplay;
+	t.vsw = mode->VSyncEnd - mode->VSyncStart;
+	t.vbp = mode->VTotal - mode->VSyncEnd;
+
+	switch (dss_check_timings(&ofb->dss_clock, &t, &div)) {
+		case DSS_MODE_OK:
+			return MODE_OK;
+		case DSS_MODE_CLOCK_INEXACT:
+			/* The kernel goes with the nearest clock as well */
+			xf86DrvMsg(output->scrn->scrnIndex, X_WARNING,
+			           "%s: %s will run at %i kHz instead of %i kHz\n",
+			           output->name, mode->name,
+			           div.pixel_clock, mode->Clock);
+			return MODE_OK;
+		case DSS_MODE_CLOCK_HIGH:
+			return MODE_CLOCK_HIGH;
+		case DSS_MODE_CLOCK_LOW:
+			return MODE_CLOCK_LOW;
+		case DSS_MODE_H_ILLEGAL:
+			return MODE_H_ILLEGAL;
+		case DSS_MODE_V_ILLEGAL:
+		default:
+			return MODE_V_ILLEGAL;
+	}
 }
 
 static Bool
@@ -188,9 +366,14 @@ OMAPFBDSSOutputSetMode (xf86OutputPtr  output,
 {
 	char timings[64];
 	OMAPFBPtr ofb = OMAPFB(output->scrn);
-	int ovl = overlayPoolGetFreeOverlay(ofb->ovlPool);
+	OMAPFBCrtcPtr ocrtc = output->crtc->driver_private;
+	int ovl = OMAPFBDSSOutputGetOverlay(output);
 
-	overlayPoolConnect(ofb->ovlPool, 0, ovl, output->name);
+	/* Connect the CRTC's framebuffer to us right away, as the CRTC needs
+	 * an overlay to set up its plane when it commits the mode
+	 */
+	overlayPoolConnect(ofb->ovlPool, ocrtc->fb_idx, ovl, output->name);
+	overlayPoolApplyConnections(ofb->ovlPool);
 
 	mode_to_timings(mode, timings, 64);
 	OMAPFBDSSOutputWriteValue(output, "timings", timings);
@@ -202,7 +385,7 @@ OMAPFBDSSOutputDetect (xf86OutputPtr output)
 	OMAPFBPtr ofb = OMAPFB(output->scrn);
 	int idx = OMAPFBDSSOutputIndex(output);
 
-	if(ofb->timings[idx][0] == '\0')
+	if(ofb->timings[idx][0] == '\0' && ofb->edid[idx].raw == NULL)
 		return XF86OutputStatusDisconnected;
 
 	return XF86OutputStatusConnected;
@@ -214,17 +397,36 @@ OMAPFBDSSOutputGetModes(xf86OutputPtr output)
 	OMAPFBPtr ofb = OMAPFB(output->scrn);
 	DisplayModePtr mode = NULL;
 	DisplayModePtr modes = NULL;
+	DisplayModePtr m;
 	int idx = OMAPFBDSSOutputIndex(output);
 
-	/* No timings, no modes */
+	/* Use the monitor's own mode list if it has one */
+	OMAPFBDSSOutputUpdateEDID(output);
+	modes = xf86OutputGetEDIDModes(output);
+
+	/* No timings, only EDID modes (if any) */
 	if(ofb->timings[idx][0] == '\0')
 		return modes;
 
-	/* Only populate the native (current) mode */
+	/* Add the native (current) mode, unless the EDID already has it */
 	mode = calloc(1, sizeof(DisplayModeRec));
-	mode->type      |= M_T_PREFERRED;
+	if (omapfb_timings_to_mode(ofb->timings[idx], mode) == FALSE) {
+		free(mode);
+		return modes;
+	}
+
+	for (m = modes; m != NULL; m = m->next) {
+		if (xf86ModesEqual(m, mode)) {
+			free(mode);
+			return modes;
+		}
+	}
+
+	/* The EDID knows better what the monitor prefers */
+	if (modes == NULL)
+		mode->type |= M_T_PREFERRED;
+	mode->type |= M_T_DRIVER;
 
-	omapfb_timings_to_mode(ofb->timings[idx], mode);
 	xf86SetModeDefaultName(mode);
 	modes = xf86ModesAdd(modes, mode);
 
@@ -275,7 +477,8 @@ OMAPFBDSSOutputProbe(ScrnInfoPtr pScrn, int index)
 
 	output_name[s-1] = '\0';
 	output = xf86OutputCreate(pScrn, &OMAPFBDSSOutputFuncs, output_name);
-	output->possible_crtcs = 0x1;
+	/* Each display has its own manager, so any CRTC can feed it */
+	output->possible_crtcs = (1 << OMAPFB(pScrn)->num_crtcs) - 1;
 	output->possible_clones = 0xff;
 	output->interlaceAllowed = FALSE;
 	output->doubleScanAllowed = FALSE;
@@ -307,7 +510,5 @@ OMAPFBOutputInitDSS(ScrnInfoPtr pScrn)
 			memset(ofb->timings[i], 0, 64);
 
 	}
-
-	ofb->ovlPool = overlayPoolInit(pScrn);
 }
 
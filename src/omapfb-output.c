@@ -69,12 +69,60 @@ OMAPFBOutputDPMS (xf86OutputPtr output, int mode)
 
 }
 
+/* Checks that a mode fits in the framebuffer memory we have */
+int
+OMAPFBOutputValidateMemory (xf86OutputPtr output,
+                            DisplayModePtr mode)
+{
+	OMAPFBPtr ofb = OMAPFB(output->scrn);
+	unsigned long size;
+
+	size = (unsigned long)mode->HDisplay * mode->VDisplay
+	       * (ofb->state_info.bits_per_pixel >> 3);
+
+	if (size > ofb->mem_info.size)
+		return MODE_MEM;
+
+	return MODE_OK;
+}
+
+/* Checks that scanning out a mode fits in the bandwidth budget on its own */
+int
+OMAPFBOutputValidateBandwidth (xf86OutputPtr output,
+                               DisplayModePtr mode)
+{
+	OMAPFBPtr ofb = OMAPFB(output->scrn);
+	struct bw_plane p;
+
+	p.src_width = mode->HDisplay;
+	p.src_height = mode->VDisplay;
+	p.bits_per_pixel = ofb->state_info.bits_per_pixel;
+	p.out_width = mode->HDisplay;
+	p.out_height = mode->VDisplay;
+	p.pixel_clock = mode->Clock;
+	p.htotal = mode->HTotal;
+	p.vtotal = mode->VTotal;
+
+	if (!bw_fits(&ofb->bandwidth, -1, bw_plane_cost(&p)))
+		return MODE_BANDWIDTH;
+
+	return MODE_OK;
+}
+
 static int
 OMAPFBOutputValidateMode (xf86OutputPtr output,
                           DisplayModePtr mode)
 {
-	/* We accept pretty much any mode */
-	return MODE_OK;
+	int status;
+
+	/* The controller timings are fixed by the kernel, so memory and
+	 * bandwidth is all we can check
+	 */
+	status = OMAPFBOutputValidateMemory(output, mode);
+	if (status != MODE_OK)
+		return status;
+
+	return OMAPFBOutputValidateBandwidth(output, mode);
 }
 
 static Bool
@@ -24,6 +24,12 @@
 #ifndef __OMAPFB_OUTPUT_H__
 #define __OMAPFB_OUTPUT_H__
 
+/* Checks that a mode fits in the framebuffer memory */
+int OMAPFBOutputValidateMemory(xf86OutputPtr output, DisplayModePtr mode);
+
+/* Checks that the mode alone fits in the scanout bandwidth budget */
+int OMAPFBOutputValidateBandwidth(xf86OutputPtr output, DisplayModePtr mode);
+
 /* For basic omapfb driver kernel API */
 void OMAPFBOutputInit(ScrnInfoPtr pScrn);
 
@@ -184,6 +184,7 @@ overlayPoolInit(ScrnInfoPtr pScrn)
 		pool->fb_map[i] = -1;
 		pool->mgr_map[i] = -1;
 		pool->mapping_dirty[i] = FALSE;
+		pool->reserved[i] = FALSE;
 	}
 
 	pool->framebuffers = 0;
@@ -205,8 +206,8 @@ int
 overlayPoolGetFreeOverlay(OverlayPoolPtr pool)
 {
 	int i;
-	for (i = 0; i < OMAPFB_MAX_DISPLAYS; i++) {
-		if (pool->mgr_map[i] == -1)
+	for (i = 0; i < pool->overlays; i++) {
+		if (pool->mgr_map[i] == -1 && !pool->reserved[i])
 		{
 			return i;
 		}
@@ -217,12 +218,56 @@ overlayPoolGetFreeOverlay(OverlayPoolPtr pool)
 	return -1;
 }
 
+/* Returns the first free overlay that can scale (not the GFX one) */
+int
+overlayPoolGetFreeScalingOverlay(OverlayPoolPtr pool)
+{
+	int i;
+	for (i = 0; i < pool->overlays; i++) {
+		char name[32];
+		if (pool->mgr_map[i] != -1 || pool->reserved[i])
+			continue;
+		if (read_dss_sysfs_value("overlay", i, "name", name, 32) == -1
+		 || strncmp(name, "gfx", 3) == 0)
+			continue;
+		return i;
+	}
+
+	xf86DrvMsg(pool->scrn->scrnIndex, X_WARNING, "%s: no free scaling overlays\n", __FUNCTION__);
+
+	return -1;
+}
+
+/* Takes the last free overlay out of the pool for private use */
+int
+overlayPoolReserveOverlay(OverlayPoolPtr pool)
+{
+	int i;
+
+	/* Keep the first ones for displays, the last one is usually
+	 * the topmost one too
+	 */
+	for (i = pool->overlays - 1; i > 0; i--) {
+		if (pool->mgr_map[i] == -1 && !pool->reserved[i])
+		{
+			pool->reserved[i] = TRUE;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
 /* Makes the framebuffer -> overlay -> display connection */
 int
 overlayPoolConnect(OverlayPoolPtr pool, int fb, int overlay, char *display)
 {
-	int manager = overlayPoolManagerForDisplay(pool, display);
+	int manager;
+
+	if (overlay < 0 || overlay >= pool->overlays)
+		return FALSE;
 
+	manager = overlayPoolManagerForDisplay(pool, display);
 	if (manager == -1)
 		return FALSE;
 
@@ -246,7 +291,7 @@ overlayPoolDisconnect(OverlayPoolPtr pool, char *display)
 
 	for (i = 0; i < pool->overlays; i++)
 	{
-		if (pool->mgr_map[i] == manager)
+		if (pool->mgr_map[i] == manager && !pool->reserved[i])
 			overlay = i;
 	}
 
@@ -273,7 +318,7 @@ overlayPoolDisplayConnected(OverlayPoolPtr pool, char *display)
 
 	for (i = 0; i < pool->overlays; i++)
 	{
-		if (pool->mgr_map[i] == manager)
+		if (pool->mgr_map[i] == manager && !pool->reserved[i])
 			overlay = i;
 	}
 
@@ -47,6 +47,11 @@ typedef struct _OverlayPoolRec {
 	int mgr_map[OMAPFB_MAX_DISPLAYS];
 
 	int mapping_dirty[OMAPFB_MAX_DISPLAYS];
+
+	/* Overlays taken for other uses than showing a display's
+	 * framebuffer, indexed by overlays
+	 */
+	int reserved[OMAPFB_MAX_DISPLAYS];
 	
 } OverlayPoolRec, *OverlayPoolPtr;
 
@@ -55,6 +60,12 @@ OverlayPoolPtr overlayPoolInit(ScrnInfoPtr pScrn);
 /* Returns the first free overlay */
 int overlayPoolGetFreeOverlay(OverlayPoolPtr pool);
 
+/* Returns the first free overlay that can scale (not the GFX one) */
+int overlayPoolGetFreeScalingOverlay(OverlayPoolPtr pool);
+
+/* Takes the last free overlay out of the pool for private use */
+int overlayPoolReserveOverlay(OverlayPoolPtr pool);
+
 /* Makes the framebuffer -> overlay -> display connection */
 int overlayPoolConnect(OverlayPoolPtr pool, int fb, int overlay, char *display);
 
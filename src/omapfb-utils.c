@@ -115,12 +115,12 @@ omapfb_timings_to_mode(const char *timings, DisplayModePtr mode)
 	mode->SynthClock = clock;
 	mode->HDisplay = width;
 	mode->HSyncStart = width + hfp;
-	mode->HSyncEnd = width + hbp;
+	mode->HSyncEnd = width + hfp + hsw;
 	mode->HTotal = width + hfp + hbp + hsw;
 	mode->HSkew = 0;
 	mode->VDisplay = height;
 	mode->VSyncStart = height + vfp;
-	mode->VSyncEnd = height + vbp;
+	mode->VSyncEnd = height + vfp + vsw;
 	mode->VTotal = height + vfp + vbp + vsw;
 	mode->VScan = 0;
 
@@ -142,12 +142,12 @@ mode_to_timings(DisplayModePtr mode, char *timings, int size)
 	int clock = mode->Clock;
 	int width = mode->HDisplay;
 	int hfp = mode->HSyncStart - width;
-	int hbp = mode->HSyncEnd - width;
-	int hsw = mode->HTotal - width - hfp - hbp;
+	int hsw = mode->HSyncEnd - mode->HSyncStart;
+	int hbp = mode->HTotal - mode->HSyncEnd;
 	int height = mode->VDisplay;
 	int vfp = mode->VSyncStart - height;
-	int vbp = mode->VSyncEnd - height;
-	int vsw = mode->VTotal - height - vfp - vbp;
+	int vsw = mode->VSyncEnd - mode->VSyncStart;
+	int vbp = mode->VTotal - mode->VSyncEnd;
 	snprintf(timings, size, "%i,%i/%i/%i/%i,%i/%i/%i/%i",
 	         clock,
 	         width, hfp, hbp, hsw,
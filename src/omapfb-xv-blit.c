@@ -0,0 +1,395 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * XV adaptor that scales and converts video in software straight into the
+ * screen, with bilinear filtering. Slower than the overlay, but it works
+ * on every screen and isn't limited to one video at a time.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "xf86.h"
+#include "xf86_OSlib.h"
+#include "xf86xv.h"
+#include "fourcc.h"
+#include "damage.h"
+
+#include <X11/extensions/Xv.h>
+#include <stdint.h>
+
+#include "omapfb-driver.h"
+#include "omapfb-xv-platform.h"
+#include "image-format-conversions.h"
+
+#define OMAPXV_BLIT_PORTS 4
+
+typedef struct {
+	/* Colour controls, and the conversion they make up */
+	int brightness;
+	int contrast;
+	int saturation;
+	int hue;
+	Bool bt709;
+	struct csc_matrix csc;
+	/* Source lines blended for the current destination line: packed
+	 * or Y, then U and V for planar
+	 */
+	uint8_t *line;
+	int line_size;
+} OMAPXVBlitPortRec, *OMAPXVBlitPortPtr;
+
+static XF86VideoEncodingRec blit_encodings[] = {
+    { 0, "XV_IMAGE", 2048, 2048, { 1, 1 } },
+};
+
+static XF86VideoFormatRec blit_formats[] = {
+    { 16, TrueColor },
+    { 24, TrueColor },
+};
+
+static XF86ImageRec blit_images[] = {
+    XVIMAGE_YUY2,
+    XVIMAGE_UYVY,
+    XVIMAGE_I420,
+    XVIMAGE_YV12,
+};
+
+static XF86AttributeRec blit_attributes[] = {
+    { XvSettable | XvGettable, -1000, 1000, "XV_BRIGHTNESS" },
+    { XvSettable | XvGettable, -1000, 1000, "XV_CONTRAST" },
+    { XvSettable | XvGettable, -1000, 1000, "XV_SATURATION" },
+    { XvSettable | XvGettable, -1000, 1000, "XV_HUE" },
+    { XvSettable | XvGettable, 0, 1, "XV_ITURBT_709" },
+};
+
+static Atom xvBrightness, xvContrast, xvSaturation, xvHue, xvBT709;
+
+#define MAKE_ATOM(a) MakeAtom(a, sizeof(a) - 1, TRUE)
+
+static int OMAPXVBlitSetPortAttribute (ScrnInfoPtr pScrn, Atom attribute,
+                                       INT32 value, pointer data)
+{
+	OMAPXVBlitPortPtr port = data;
+
+	if (attribute == xvBT709) {
+		if (value < 0 || value > 1)
+			return BadValue;
+		port->bt709 = value;
+	} else {
+		if (value < -1000 || value > 1000)
+			return BadValue;
+		if (attribute == xvBrightness)
+			port->brightness = value;
+		else if (attribute == xvContrast)
+			port->contrast = value;
+		else if (attribute == xvSaturation)
+			port->saturation = value;
+		else if (attribute == xvHue)
+			port->hue = value;
+		else
+			return BadMatch;
+	}
+
+	/* The controls cost nothing per pixel, they're folded into the
+	 * conversion we do anyway
+	 */
+	csc_matrix_init(&port->csc, port->bt709, port->brightness,
+	                port->contrast, port->saturation, port->hue);
+
+	return Success;
+}
+
+static int OMAPXVBlitGetPortAttribute (ScrnInfoPtr pScrn, Atom attribute,
+                                       INT32 *value, pointer data)
+{
+	OMAPXVBlitPortPtr port = data;
+
+	if (attribute == xvBrightness)
+		*value = port->brightness;
+	else if (attribute == xvContrast)
+		*value = port->contrast;
+	else if (attribute == xvSaturation)
+		*value = port->saturation;
+	else if (attribute == xvHue)
+		*value = port->hue;
+	else if (attribute == xvBT709)
+		*value = port->bt709;
+	else
+		return BadMatch;
+
+	return Success;
+}
+
+static void OMAPXVBlitQueryBestSize (ScrnInfoPtr pScrn,
+                                     Bool motion, short vid_w, short vid_h,
+                                     short drw_w, short drw_h,
+                                     unsigned int *p_w, unsigned int *p_h,
+                                     pointer data)
+{
+	*p_w = drw_w;
+	*p_h = drw_h;
+}
+
+static int OMAPXVBlitQueryImageAttributes (ScrnInfoPtr pScrn, int id,
+                                           unsigned short *width,
+                                           unsigned short *height,
+                                           int *pitches, int *offsets)
+{
+	return OMAPXVImageLayout(id, width, height, pitches, offsets);
+}
+
+/* Source row and blend fraction for a 16.16 fixed point position */
+static void OMAPXVBlitRow (int pos, int rows, int *row, int *frac)
+{
+	*row = pos > 0 ? pos >> 16 : 0;
+	*frac = pos > 0 ? (pos >> 8) & 0xff : 0;
+	if (*row >= rows - 1) {
+		*row = rows - 1;
+		*frac = 0;
+	}
+}
+
+static int OMAPXVBlitPutImage (ScrnInfoPtr pScrn,
+                               short src_x, short src_y, short drw_x, short drw_y,
+                               short src_w, short src_h, short drw_w, short drw_h,
+                               int image, unsigned char *buf, short width, short height,
+                               Bool sync, RegionPtr clipBoxes, pointer data,
+                               DrawablePtr pDraw)
+{
+	OMAPXVBlitPortPtr port = data;
+	ScreenPtr pScreen = pDraw->pScreen;
+	PixmapPtr pPixmap;
+	int bpp;
+	BoxPtr box = REGION_RECTS(clipBoxes);
+	int nbox = REGION_NUM_RECTS(clipBoxes);
+	int pitches[3], offsets[3];
+	unsigned short w = width, h = height;
+	Bool planar = (image == FOURCC_I420 || image == FOURCC_YV12);
+	uint8_t *y_src, *u_src = NULL, *v_src = NULL;
+	uint8_t *y_line, *u_line, *v_line;
+	int y_inc, uv_inc, len, uv_len;
+	int xstep, ystep;
+	int xoff = 0, yoff = 0;
+
+	if (src_w <= 0 || src_h <= 0 || drw_w <= 0 || drw_h <= 0)
+		return Success;
+
+	if (pDraw->type == DRAWABLE_WINDOW)
+		pPixmap = (*pScreen->GetWindowPixmap)((WindowPtr)pDraw);
+	else
+		pPixmap = (PixmapPtr)pDraw;
+
+	/* A redirected window can be deeper than the screen */
+	bpp = pPixmap->drawable.bitsPerPixel >> 3;
+	if (bpp != 2 && bpp != 4)
+		return BadMatch;
+#ifdef COMPOSITE
+	/* The clip is in screen coordinates, the pixmap may not be */
+	xoff = -pPixmap->screen_x;
+	yoff = -pPixmap->screen_y;
+#endif
+
+	/* Chroma pairs stay together */
+	src_x &= ~1;
+
+	OMAPXVImageLayout(image, &w, &h, pitches, offsets);
+	y_src = buf + offsets[0] + src_y * pitches[0];
+	if (planar) {
+		u_src = buf + offsets[1] + (src_y / 2) * pitches[1] + src_x / 2;
+		v_src = buf + offsets[2] + (src_y / 2) * pitches[2] + src_x / 2;
+		if (image == FOURCC_YV12) {
+			uint8_t *tmp = u_src;
+			u_src = v_src;
+			v_src = tmp;
+		}
+		y_src += src_x;
+		len = src_w;
+		uv_len = (src_w + 1) / 2;
+	} else {
+		y_src += src_x * 2;
+		len = ((src_w + 1) & ~1) * 2;
+		uv_len = 0;
+	}
+
+	if (port->line_size < len + 2 * uv_len) {
+		uint8_t *line = realloc(port->line, len + 2 * uv_len);
+		if (line == NULL)
+			return BadAlloc;
+		port->line = line;
+		port->line_size = len + 2 * uv_len;
+	}
+
+	y_line = port->line;
+	if (planar) {
+		u_line = y_line + len;
+		v_line = u_line + uv_len;
+		y_inc = 1;
+		uv_inc = 1;
+	} else if (image == FOURCC_UYVY) {
+		/* [U Y1 | V Y2] */
+		u_line = y_line;
+		v_line = y_line + 2;
+		y_line++;
+		y_inc = 2;
+		uv_inc = 4;
+	} else {
+		/* [Y1 U | Y2 V] */
+		u_line = y_line + 1;
+		v_line = y_line + 3;
+		y_inc = 2;
+		uv_inc = 4;
+	}
+
+	xstep = (src_w << 16) / drw_w;
+	ystep = (src_h << 16) / drw_h;
+
+	/* Go through the clip a band of boxes at a time, so that each
+	 * destination line is blended vertically only once
+	 */
+	while (nbox > 0) {
+		int band = 1;
+		int y, y1, y2;
+
+		while (band < nbox && box[band].y1 == box[0].y1)
+			band++;
+
+		y1 = max(box->y1, drw_y);
+		y2 = min(box->y2, drw_y + drw_h);
+
+		for (y = y1; y < y2; y++) {
+			int pos = (y - drw_y) * ystep + ystep / 2 - 32768;
+			int row, frac, i;
+
+			OMAPXVBlitRow(pos, src_h, &row, &frac);
+			line_blend(len, frac, y_src + row * pitches[0],
+			           y_src + (row + (frac != 0)) * pitches[0],
+			           port->line);
+
+			if (planar) {
+				/* Chroma rows sit between each pair of luma rows */
+				OMAPXVBlitRow((pos >> 1) - 16384, (src_h + 1) / 2,
+				              &row, &frac);
+				line_blend(uv_len, frac, u_src + row * pitches[1],
+				           u_src + (row + (frac != 0)) * pitches[1],
+				           u_line);
+				line_blend(uv_len, frac, v_src + row * pitches[2],
+				           v_src + (row + (frac != 0)) * pitches[2],
+				           v_line);
+			}
+
+			for (i = 0; i < band; i++) {
+				int x1 = max(box[i].x1, drw_x);
+				int x2 = min(box[i].x2, drw_x + drw_w);
+				uint8_t *dest;
+
+				if (x1 >= x2)
+					continue;
+
+				dest = (uint8_t *)pPixmap->devPrivate.ptr
+				       + (y + yoff) * pPixmap->devKind
+				       + (x1 + xoff) * bpp;
+				yuv_scale_line_to_rgb(x2 - x1,
+				                      (x1 - drw_x) * xstep + xstep / 2 - 32768,
+				                      xstep, src_w,
+				                      y_line, y_inc,
+				                      u_line, v_line, uv_inc,
+				                      &port->csc, bpp, dest);
+			}
+		}
+
+		box += band;
+		nbox -= band;
+	}
+
+	/* We went around fb, let the damage tracking know */
+	DamageDamageRegion(pDraw, clipBoxes);
+
+	return Success;
+}
+
+static void OMAPXVBlitStopVideo (ScrnInfoPtr pScrn, pointer data, Bool cleanup)
+{
+	OMAPXVBlitPortPtr port = data;
+
+	/* What was drawn stays, only the line buffer can go */
+	if (cleanup) {
+		free(port->line);
+		port->line = NULL;
+		port->line_size = 0;
+	}
+}
+
+XF86VideoAdaptorPtr OMAPFBXVBlitInit (ScrnInfoPtr pScrn)
+{
+	XF86VideoAdaptorPtr adaptor;
+	OMAPXVBlitPortPtr ports;
+	int i;
+
+	if (pScrn->bitsPerPixel != 16 && pScrn->bitsPerPixel != 32) {
+		xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+		           "XV: No blitter for %i bits per pixel\n",
+		           pScrn->bitsPerPixel);
+		return NULL;
+	}
+
+	adaptor = xf86XVAllocateVideoAdaptorRec(pScrn);
+	if (adaptor == NULL)
+		return NULL;
+
+	adaptor->pPortPrivates = xnfcalloc(OMAPXV_BLIT_PORTS, sizeof(DevUnion));
+	ports = xnfcalloc(OMAPXV_BLIT_PORTS, sizeof(OMAPXVBlitPortRec));
+	for (i = 0; i < OMAPXV_BLIT_PORTS; i++) {
+		csc_matrix_init(&ports[i].csc, FALSE, 0, 0, 0, 0);
+		adaptor->pPortPrivates[i].ptr = &ports[i];
+	}
+
+	xvBrightness = MAKE_ATOM("XV_BRIGHTNESS");
+	xvContrast = MAKE_ATOM("XV_CONTRAST");
+	xvSaturation = MAKE_ATOM("XV_SATURATION");
+	xvHue = MAKE_ATOM("XV_HUE");
+	xvBT709 = MAKE_ATOM("XV_ITURBT_709");
+
+	adaptor->type = XvInputMask | XvImageMask | XvWindowMask;
+	adaptor->flags = VIDEO_CLIP_TO_VIEWPORT;
+	adaptor->name = xstrdup("OMAP XV blitter");
+	adaptor->nEncodings = 1;
+	adaptor->pEncodings = blit_encodings;
+	adaptor->nFormats = sizeof(blit_formats) / sizeof(blit_formats[0]);
+	adaptor->pFormats = blit_formats;
+	adaptor->nPorts = OMAPXV_BLIT_PORTS;
+	adaptor->nAttributes = sizeof(blit_attributes) / sizeof(blit_attributes[0]);
+	adaptor->pAttributes = blit_attributes;
+	adaptor->nImages = sizeof(blit_images) / sizeof(blit_images[0]);
+	adaptor->pImages = blit_images;
+	adaptor->SetPortAttribute = OMAPXVBlitSetPortAttribute;
+	adaptor->GetPortAttribute = OMAPXVBlitGetPortAttribute;
+	adaptor->QueryBestSize = OMAPXVBlitQueryBestSize;
+	adaptor->QueryImageAttributes = OMAPXVBlitQueryImageAttributes;
+	adaptor->PutImage = OMAPXVBlitPutImage;
+	adaptor->StopVideo = OMAPXVBlitStopVideo;
+
+	return adaptor;
+}
@@ -86,6 +86,53 @@ static int OMAPFBXVApplyClip(ScrnInfoPtr pScrn, RegionPtr clipBoxes)
 	return Success;
 }
 
+/* A tear synced update waits for the panel to reach the right line, which
+ * can take up to a refresh period. Keep doing that only while the frames
+ * leave time for it, and update right away when they don't. busy is the
+ * time the frame took to convert, without any wait for the display.
+ */
+static void OMAPFBXVTearSyncPolicy(ScrnInfoPtr pScrn, CARD32 start, int busy)
+{
+	OMAPFBPortPtr port = OMAPFB(pScrn)->port;
+
+	if (port->last_frame != 0) {
+		int interval = start - port->last_frame;
+		if (port->frame_interval == 0)
+			port->frame_interval = interval;
+		else
+			port->frame_interval = (port->frame_interval * 7 + interval) / 8;
+	}
+	port->last_frame = start;
+
+	if (!port->tearsync || port->frame_interval == 0)
+		return;
+
+	if (port->tearsync_active && busy * 4 > port->frame_interval * 3) {
+		xf86DrvMsgVerb(pScrn->scrnIndex, X_INFO, 3,
+		               "XV: Frames too tight for tearsync (%i/%i ms)\n",
+		               busy, port->frame_interval);
+		port->tearsync_active = FALSE;
+	} else if (!port->tearsync_active && busy * 2 < port->frame_interval) {
+		xf86DrvMsgVerb(pScrn->scrnIndex, X_INFO, 3,
+		               "XV: Tearsync back on (%i/%i ms)\n",
+		               busy, port->frame_interval);
+		port->tearsync_active = TRUE;
+	}
+}
+
+/* Color format the controller gets the image in */
+static enum omapfb_color_format OMAPXVBlizzardFormat(ScrnInfoPtr pScrn,
+                                                     int image)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	if (ofb->port->planar
+	 && (image == FOURCC_I420 || image == FOURCC_YV12))
+		return OMAPFB_COLOR_YUV420;
+
+	return xv_to_omapfb_format(image);
+}
+
 /* Blizzard is Epson S1D13745A01, found on eg. Nokia N8x0 */
 int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
                               short src_x, short src_y, short drw_x, short drw_y,
@@ -96,6 +143,9 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 {
 	struct omapfb_update_window w;
 	OMAPFBPtr ofb = OMAPFB(pScrn);
+	CARD32 start = GetTimeInMillis();
+	uint8_t *dest;
+	int back, busy;
 	int do_clip = !REGION_EQUAL(pScrn, &ofb->port->current_clip, clipBoxes);
 
 	if (!ofb->port->plane_info.enabled
@@ -103,7 +153,7 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 	 || ofb->port->update_window.y != src_y
 	 || ofb->port->update_window.width != src_w
 	 || ofb->port->update_window.height != src_h
-	 || ofb->port->update_window.format != xv_to_omapfb_format(image)
+	 || ofb->port->format != OMAPXVBlizzardFormat(pScrn, image)
 	 || ofb->port->update_window.out_x != drw_x
 	 || ofb->port->update_window.out_y != drw_y
 	 || ofb->port->update_window.out_width != drw_w
@@ -141,11 +191,26 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 			return Success;
 		}
 
+		/* A bigger image doesn't fit the memory the plane has,
+		 * which can only be resized when it's off
+		 */
+		if (ofb->port->plane_info.enabled
+		 && ofb->port->mem_info.size > ofb->port->mapped_size)
+			OMAPFBXVStopVideoBlizzard(pScrn, NULL, FALSE);
+
 		/* If we don't have the plane running, enable it */
 		if (!ofb->port->plane_info.enabled) {
 			ret = OMAPXVAllocPlane(pScrn);
+			if (ret != Success && ofb->port->pages > 1) {
+				xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+				           "XV: No memory for two video buffers, "
+				           "updates will not be pipelined\n");
+				ofb->port->mem_info.size /= ofb->port->pages;
+				ofb->port->pages = 1;
+				ret = OMAPXVAllocPlane(pScrn);
+			}
 			if (ret != Success)
-				return ret;
+				return OMAPXVSetupFailed(pScrn, ret);
 		}
 
 		/* Set up the state info, xres and yres will be used for
@@ -154,14 +219,21 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 		ofb->port->state_info.xres = src_w & ~3;
 		ofb->port->state_info.yres = src_h & ~3;
 		ofb->port->state_info.xres_virtual = src_w & ~3;
-		ofb->port->state_info.yres_virtual = src_h & ~3;
+		ofb->port->state_info.yres_virtual = (src_h & ~3) * ofb->port->pages;
 		ofb->port->state_info.xoffset = 0;
 		ofb->port->state_info.yoffset = 0;
 		ofb->port->state_info.rotate = 0;
 		ofb->port->state_info.grayscale = 0;
 		ofb->port->state_info.activate = FB_ACTIVATE_NOW;
 		ofb->port->state_info.bits_per_pixel = 0;
-		ofb->port->state_info.nonstd = xv_to_omapfb_format(image);
+		ofb->port->state_info.nonstd = OMAPXVBlizzardFormat(pScrn, image);
+		ofb->port->format = ofb->port->state_info.nonstd;
+
+		/* The pages are stacked vertically, we start on the first */
+		ofb->port->page_height = src_h & ~3;
+		ofb->port->page_size = (src_w & ~3) * ofb->port->page_height
+		                       * (ofb->port->format == OMAPFB_COLOR_YUV420 ? 3 : 4) / 2;
+		ofb->port->front_page = 0;
 
 		/* Set up the video plane info */
 		ofb->port->plane_info.enabled = 1;
@@ -191,9 +263,31 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 			}
 		}
 
+		/* Video shown at twice its size or more can be sent at half
+		 * the output size and have the controller double the pixels,
+		 * which is a quarter of the data over the bus
+		 */
+		ofb->port->doubled = ofb->port->pixel_double
+		                  && drw_w >= 2 * src_w && drw_h >= 2 * src_h;
+		if (ofb->port->doubled) {
+			ofb->port->plane_info.out_width =
+				(ofb->port->plane_info.out_width / 2) & ~1;
+			ofb->port->plane_info.out_height =
+				(ofb->port->plane_info.out_height / 2) & ~1;
+		}
+
+		ofb->port->clip_yoffset = ofb->port->state_info.yoffset;
+
+		/* Don't change the plane under an update */
+		if (ofb->port->update_pending) {
+			if (ioctl (ofb->port->fd, OMAPFB_SYNC_GFX))
+				xf86Msg(X_ERROR, "%s: Graphics sync failed\n", __FUNCTION__);
+			ofb->port->update_pending = FALSE;
+		}
+
 		ret = OMAPXVSetupVideoPlane(pScrn);
 		if (ret != Success)
-			return ret;
+			return OMAPXVSetupFailed(pScrn, ret);
 
 		ret = OMAPFB_MANUAL_UPDATE;
 		if (ioctl (ofb->port->fd, OMAPFB_SET_UPDATE_MODE, &ret))
@@ -205,6 +299,10 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 
 	}
 
+	/* Convert into the page that isn't being sent */
+	back = ofb->port->pages > 1 ? !ofb->port->front_page : 0;
+	dest = (uint8_t*)ofb->port->fb + back * ofb->port->page_size;
+
 	switch (image)
 	{
 		/* Packed formats carry the YUV (luma and 2 chroma values, ie.
@@ -219,9 +317,10 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 		{
 			packed_line_copy(src_w & ~3,
 			                 src_h & ~3,
+			                 2,
 			                 ((src_w + 1) & ~1) * 2,
 			                 (uint8_t*)buf,
-			                 (uint8_t*)ofb->port->fb);
+			                 dest);
 			break;
 		}
 
@@ -232,13 +331,11 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 		 * 2x2 pixels on screen
 		 */
 
-		/* We don't actually support planar formats, as the blizzard
-		 * has (apparently) due to endianness incompatibilities a
-		 * quirky YUV420 format. Fortunately the conversion to packed
-		 * formats is cheap enough to do smooth 512x288@24fps on N800,
-		 * making support for the "custom" format unattractive. That,
-		 * and the fact that I've tried to use it (there's code around
-		 * to do that conversion) and failed :)
+		/* The blizzard has (apparently) due to endianness
+		 * incompatibilities a quirky YUV420 format, which
+		 * uv12_to_blizzard_yuv420 produces. It takes 12 bits per
+		 * pixel over the bus instead of the 16 of UYVY. Without it
+		 * we convert to packed UYVY.
 		 */
 
 		case FOURCC_I420:
@@ -249,12 +346,21 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 			uint8_t *yb = buf;
 			uint8_t *ub = yb + (src_y_pitch * src_h);
 			uint8_t *vb = ub + (src_uv_pitch * (src_h / 2));
+			if (ofb->port->format == OMAPFB_COLOR_YUV420) {
+				uv12_to_blizzard_yuv420(src_w & ~3,
+				                        src_h & ~3,
+				                        src_y_pitch,
+				                        src_uv_pitch,
+				                        yb, ub, vb,
+				                        dest);
+				break;
+			}
 			uv12_to_uyvy(src_w & ~3,
 			             src_h & ~3,
 			             src_y_pitch,
 			             src_uv_pitch,
 			             yb, ub, vb,
-			             (uint8_t*)ofb->port->fb);
+			             dest);
 			break;
 		}
 		case FOURCC_YV12:
@@ -265,12 +371,21 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 			uint8_t *yb = buf;
 			uint8_t *vb = yb + (src_y_pitch * src_h);
 			uint8_t *ub = vb + (src_uv_pitch * (src_h / 2));
+			if (ofb->port->format == OMAPFB_COLOR_YUV420) {
+				uv12_to_blizzard_yuv420(src_w & ~3,
+				                        src_h & ~3,
+				                        src_y_pitch,
+				                        src_uv_pitch,
+				                        yb, ub, vb,
+				                        dest);
+				break;
+			}
 			uv12_to_uyvy(src_w & ~3,
 			             src_h & ~3,
 			             src_y_pitch,
 			             src_uv_pitch,
 			             yb, ub, vb,
-			             (uint8_t*)ofb->port->fb);
+			             dest);
 			break;
 		}
 
@@ -288,12 +403,61 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 	w.out_width = ofb->state_info.xres;
 	w.out_height = ofb->state_info.yres;
 
+	/* Only the half size video window goes over the bus, the rest of
+	 * the screen is updated when the video stops
+	 */
+	if (ofb->port->doubled) {
+		w.x = ofb->port->plane_info.pos_x;
+		w.y = ofb->port->plane_info.pos_y;
+		w.width = ofb->port->plane_info.out_width;
+		w.height = ofb->port->plane_info.out_height;
+		w.format = ofb->port->format | OMAPFB_FORMAT_FLAG_DOUBLE;
+		w.out_x = w.x;
+		w.out_y = w.y;
+		w.out_width = w.width * 2;
+		w.out_height = w.height * 2;
+	}
+
+	/* Only the conversion counts for the tearsync policy, the wait
+	 * below is the tearsync wait itself
+	 */
+	busy = GetTimeInMillis() - start;
+
+	/* The previous update went on while we converted, it has to be
+	 * done before the next one can start
+	 */
+	if (ofb->port->update_pending) {
+		if (ioctl (ofb->port->fd, OMAPFB_SYNC_GFX))
+		{
+			xf86Msg(X_ERROR, "%s: Graphics sync failed\n", __FUNCTION__);
+			return XvBadAlloc;
+		}
+		ofb->port->update_pending = FALSE;
+	}
+
+	if (back != ofb->port->front_page) {
+		struct fb_var_screeninfo v = ofb->port->state_info;
+		v.yoffset = ofb->port->clip_yoffset + back * ofb->port->page_height;
+		if (ioctl (ofb->port->fd, FBIOPAN_DISPLAY, &v))
+		{
+			xf86Msg(X_ERROR, "%s: Failed to flip video buffers:"
+			                 " %s\n", __FUNCTION__, strerror(errno));
+			return XvBadAlloc;
+		}
+		ofb->port->front_page = back;
+	}
+
+	OMAPFBXVTearSyncPolicy(pScrn, start, busy);
+	if (ofb->port->tearsync_active)
+		w.format |= OMAPFB_FORMAT_FLAG_TEARSYNC;
+
 	if (ioctl (ofb->fd, OMAPFB_UPDATE_WINDOW, &w))
 	{
 		xf86Msg(X_ERROR, "%s: Failed to update screen:"
 		                 " %s\n", __FUNCTION__, strerror(errno));
 		return XvBadAlloc;
 	}
+	ofb->port->update_pending = TRUE;
 
 	if (sync) {
 		if (ioctl (ofb->port->fd, OMAPFB_SYNC_GFX))
@@ -301,6 +465,7 @@ int OMAPFBXVPutImageBlizzard (ScrnInfoPtr pScrn,
 			xf86Msg(X_ERROR, "%s: Graphics sync failed\n", __FUNCTION__);
 			return XvBadAlloc;
 		}
+		ofb->port->update_pending = FALSE;
 	}
 	
 	return Success;
@@ -341,10 +506,13 @@ void OMAPFBXVStopVideoBlizzard (ScrnInfoPtr pScrn, pointer data, Bool cleanup)
 			return;
 		}
 
-		mode = OMAPFB_AUTO_UPDATE;
+		/* The screen keeps on being updated from damage if the
+		 * display is a manual update one anyway
+		 */
+		mode = ofb->manual_update ? OMAPFB_MANUAL_UPDATE : OMAPFB_AUTO_UPDATE;
 		if (ioctl (ofb->port->fd, OMAPFB_SET_UPDATE_MODE, &mode))
 		{
-			xf86Msg(X_ERROR, "%s: Failed to set auto update mode:"
+			xf86Msg(X_ERROR, "%s: Failed to set update mode:"
 			                 " %s\n", __FUNCTION__, strerror(errno));
 			return;
 		}
@@ -354,8 +522,16 @@ void OMAPFBXVStopVideoBlizzard (ScrnInfoPtr pScrn, pointer data, Bool cleanup)
 			           "Failed to query video plane info\n");
 		}
 
+		ofb->port->update_pending = FALSE;
+		ofb->port->front_page = 0;
+		ofb->port->last_frame = 0;
+		ofb->port->frame_interval = 0;
+		ofb->port->tearsync_active = ofb->port->tearsync;
+
 		/* Disable the video plane */
-		munmap(ofb->port->fb, ofb->port->mem_info.size);
+		munmap(ofb->port->fb, ofb->port->mapped_size);
+		ofb->port->fb = NULL;
+		ofb->port->mapped_size = 0;
 		ofb->port->plane_info.enabled = 0;
 		if (ioctl (ofb->port->fd, OMAPFB_SETUP_PLANE, &ofb->port->plane_info)) {
 			xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
@@ -34,9 +34,18 @@
 #include <stdint.h>
 
 #include "omapfb-driver.h"
+#include "omapfb-crtc.h"
+#include "omapfb-damage.h"
 #include "omapfb-xv-platform.h"
 #include "image-format-conversions.h"
 
+/* How much the video overlay scaler can shrink, anything more is first
+ * decimated in software
+ */
+#define OMAPXV_MAX_DOWNSCALE 2
+/* Largest software decimation factor, thumbnails of HD video need it */
+#define OMAPXV_MAX_DECIMATE 8
+
 enum omapfb_color_format xv_to_omapfb_format(int format)
 {
 	switch (format)
@@ -49,9 +58,17 @@ enum omapfb_color_format xv_to_omapfb_format(int format)
 		case FOURCC_YV12:
 			/* Unfortunately dispc doesn't support planar formats
 			 * (at least currently) so we'll need to convert
-			 * to packed (UYVY)
+			 * to packed (UYVY). Planes that do take them are
+			 * handled in OMAPXVPlaneFormat.
 			 */
 			return OMAPFB_COLOR_YUV422;
+		case FOURCC_NV12:
+			/* No omapfb format for this one at all */
+			return OMAPFB_COLOR_YUV422;
+		case FOURCC_RGB565:
+			return OMAPFB_COLOR_RGB565;
+		case FOURCC_XRGB8888:
+			return OMAPFB_COLOR_RGB24U;
 		default:
 			return -1;
 	}
@@ -73,11 +90,14 @@ int OMAPXVAllocPlane(ScrnInfoPtr pScrn)
 	ofb->port->fb = mmap (NULL, ofb->port->mem_info.size,
 	                PROT_READ | PROT_WRITE, MAP_SHARED,
 	                ofb->port->fd, 0);
-	if (ofb->port->fb == NULL) {
+	if (ofb->port->fb == MAP_FAILED) {
 		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
 		           "Mapping video memory failed\n");
+		ofb->port->fb = NULL;
+		ofb->port->mapped_size = 0;
 		return XvBadAlloc;
 	}
+	ofb->port->mapped_size = ofb->port->mem_info.size;
 
 	/* Update the state info */
 	if (ioctl (ofb->port->fd, FBIOGET_VSCREENINFO, &ofb->port->state_info))
@@ -90,9 +110,136 @@ int OMAPXVAllocPlane(ScrnInfoPtr pScrn)
 }
 
 
+int OMAPXVSetupFailed(ScrnInfoPtr pScrn, int ret)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	memset(&ofb->port->update_window, 0, sizeof(ofb->port->update_window));
+
+	return ret;
+}
+
+/* Color format for the plane, which may differ from what the image is
+ * converted to in general
+ */
+static enum omapfb_color_format OMAPXVPlaneFormat(ScrnInfoPtr pScrn, int image)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	if ((image == FOURCC_I420 || image == FOURCC_YV12)
+	 && ofb->port->planar && ofb->port->decimate == 1)
+		return OMAPFB_COLOR_YUV420;
+
+	return xv_to_omapfb_format(image);
+}
+
+/* Sets up the pixel format of the plane. RGB goes by the depth, the
+ * rest by the omapfb color format.
+ */
+static void OMAPXVSetPixelFormat(struct fb_var_screeninfo *v,
+                                 enum omapfb_color_format format)
+{
+	memset(&v->red, 0, sizeof(v->red));
+	memset(&v->green, 0, sizeof(v->green));
+	memset(&v->blue, 0, sizeof(v->blue));
+	memset(&v->transp, 0, sizeof(v->transp));
+
+	switch (format)
+	{
+		case OMAPFB_COLOR_RGB565:
+			v->nonstd = 0;
+			v->bits_per_pixel = 16;
+			v->red.offset = 11;
+			v->red.length = 5;
+			v->green.offset = 5;
+			v->green.length = 6;
+			v->blue.length = 5;
+			break;
+		case OMAPFB_COLOR_RGB24U:
+			v->nonstd = 0;
+			v->bits_per_pixel = 32;
+			v->red.offset = 16;
+			v->red.length = 8;
+			v->green.offset = 8;
+			v->green.length = 8;
+			v->blue.length = 8;
+			break;
+		default:
+			v->nonstd = format;
+			v->bits_per_pixel = 0;
+			break;
+	}
+}
+
+/* Scanout bandwidth the video plane would need on the base CRTC */
+static unsigned long OMAPXVPlaneBandwidth(ScrnInfoPtr pScrn, int image,
+                                          int src_w, int src_h,
+                                          int out_w, int out_h)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+
+	if (ofb->num_crtcs == 0)
+		return 0;
+
+	/* Everything but XRGB8888 is shown as a 16bpp format (or less) */
+	return OMAPFBCrtcPlaneBandwidth(ofb->crtcs[0], src_w, src_h,
+	                                image == FOURCC_XRGB8888 ? 32 : 16,
+	                                out_w, out_h);
+}
+
+/* Picks how much to shrink the source in software, so that the scaler
+ * stays within its limits and the plane within the bandwidth budget
+ */
+static int OMAPXVDecimation(ScrnInfoPtr pScrn, int image,
+                            int src_w, int src_h, int out_w, int out_h,
+                            unsigned long *bandwidth)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int factor = 1;
+
+	*bandwidth = OMAPXVPlaneBandwidth(pScrn, image, src_w, src_h,
+	                                  out_w, out_h);
+
+	/* Only the YUV formats have decimating conversions */
+	if (out_w < 1 || out_h < 1
+	 || (image != FOURCC_YUY2 && image != FOURCC_UYVY
+	  && image != FOURCC_I420 && image != FOURCC_YV12))
+		return 1;
+
+	while (factor < OMAPXV_MAX_DECIMATE
+	    && (src_w / factor > out_w * OMAPXV_MAX_DOWNSCALE
+	     || src_h / factor > out_h * OMAPXV_MAX_DOWNSCALE))
+		factor *= 2;
+
+	*bandwidth = OMAPXVPlaneBandwidth(pScrn, image, src_w / factor, src_h / factor,
+	                                  out_w, out_h);
+	while (factor < OMAPXV_MAX_DECIMATE
+	    && !bw_fits(&ofb->bandwidth, OMAPFB_BW_VIDEO, *bandwidth)) {
+		factor *= 2;
+		*bandwidth = OMAPXVPlaneBandwidth(pScrn, image, src_w / factor,
+		                                  src_h / factor, out_w, out_h);
+	}
+
+	return factor;
+}
+
 int OMAPXVSetupVideoPlane(ScrnInfoPtr pScrn)
 {
 	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int x = ofb->port->plane_info.pos_x;
+	int y = ofb->port->plane_info.pos_y;
+	int w = ofb->port->plane_info.out_width;
+	int h = ofb->port->plane_info.out_height;
+
+	/* The plane is placed on the display, which may be rotated from
+	 * how the screen sees it. The video gets rotated the same way.
+	 */
+	OMAPFBCrtcTransformRect(pScrn, &x, &y, &w, &h);
+	ofb->port->plane_info.pos_x = x;
+	ofb->port->plane_info.pos_y = y;
+	ofb->port->plane_info.out_width = w;
+	ofb->port->plane_info.out_height = h;
+	ofb->port->state_info.rotate = ofb->state_info.rotate;
 
 	if (ioctl (ofb->port->fd, FBIOPUT_VSCREENINFO, &ofb->port->state_info))
 	{
@@ -116,6 +263,122 @@ int OMAPXVSetupVideoPlane(ScrnInfoPtr pScrn)
 	return Success;
 }
 
+/* Manual update displays only show the video area once it is sent */
+static void OMAPXVUpdateVideoArea(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	BoxRec box;
+
+	box.x1 = ofb->port->update_window.out_x;
+	box.y1 = ofb->port->update_window.out_y;
+	box.x2 = box.x1 + ofb->port->update_window.out_width;
+	box.y2 = box.y1 + ofb->port->update_window.out_height;
+	OMAPFBDamageUpdate(pScrn, &box);
+}
+
+/* Stops pacing frames, the plane is about to change or go away */
+static void OMAPXVStopQueue(ScrnInfoPtr pScrn)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	struct omapxv_queue_stats stats;
+
+	if (ofb->port->queue == NULL)
+		return;
+
+	OMAPXVQueueDestroy(ofb->port->queue, &stats);
+	ofb->port->queue = NULL;
+
+	xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+	           "XV: %lu frames shown, %lu repeated, %lu dropped\n",
+	           stats.shown, stats.repeated, stats.dropped);
+}
+
+/* Source size after decimation. The lines are kept a multiple of 16
+ * pixels like without decimation, there only needs to be an even number
+ * of them so that the chroma rows stay paired.
+ */
+static int OMAPXVDecimatedWidth(OMAPFBPortPtr port, int s)
+{
+	return (s & ~(16 * port->decimate - 1)) / port->decimate;
+}
+
+static int OMAPXVDecimatedHeight(OMAPFBPortPtr port, int s)
+{
+	if (port->decimate > 1)
+		return (s & ~(2 * port->decimate - 1)) / port->decimate;
+
+	return s & ~15;
+}
+
+/* Converts a frame to the plane while shrinking it. A single field is
+ * shrunk from its own lines only, so the fields don't get mixed.
+ */
+static int OMAPXVPutDecimated(ScrnInfoPtr pScrn, short src_w, short src_h,
+                              int image, unsigned char *buf,
+                              uint8_t *dest, Bool sync)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int factor = ofb->port->decimate;
+	int field = ofb->port->shown_field;
+	int w = OMAPXVDecimatedWidth(ofb->port, src_w) * factor;
+	int h = OMAPXVDecimatedHeight(ofb->port, src_h) * factor;
+	/* Every other line belongs to the field */
+	int lines = field ? 2 : 1;
+	int skip = field == 2 ? 1 : 0;
+
+	h /= lines;
+
+	switch (image)
+	{
+		case FOURCC_UYVY:
+		case FOURCC_YUY2:
+		{
+			int stride = ((src_w + 1) & ~1) * 2;
+			packed_decimate(w, h, factor,
+			                stride * lines,
+			                image == FOURCC_UYVY ? 1 : 0,
+			                (uint8_t*)buf + stride * skip,
+			                dest);
+			break;
+		}
+		case FOURCC_I420:
+		case FOURCC_YV12:
+		{
+			int src_y_pitch = (src_w + 3) & ~3;
+			int src_uv_pitch = (((src_y_pitch >> 1) + 3) & ~3);
+			uint8_t *yb = buf;
+			uint8_t *ub = yb + (src_y_pitch * src_h);
+			uint8_t *vb = ub + (src_uv_pitch * (src_h / 2));
+			/* YV12 has the chroma planes the other way around */
+			if (image == FOURCC_YV12) {
+				uint8_t *tmp = ub;
+				ub = vb;
+				vb = tmp;
+			}
+			uv12_to_uyvy_decimate(w, h, factor,
+			                      src_y_pitch * lines,
+			                      src_uv_pitch * lines,
+			                      yb + src_y_pitch * skip,
+			                      ub + src_uv_pitch * skip,
+			                      vb + src_uv_pitch * skip,
+			                      dest);
+			break;
+		}
+		default:
+			break;
+	}
+
+	if (sync) {
+		if (ioctl (ofb->port->fd, OMAPFB_SYNC_GFX))
+		{
+			xf86Msg(X_ERROR, "%s: Graphics sync failed\n", __FUNCTION__);
+			return XvBadAlloc;
+		}
+	}
+
+	return Success;
+}
+
 int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
                              short src_x, short src_y, short drw_x, short drw_y,
                              short src_w, short src_h, short drw_w, short drw_h,
@@ -124,19 +387,26 @@ int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
                              DrawablePtr pDraw)
 {
 	OMAPFBPtr ofb = OMAPFB(pScrn);
+	unsigned long bandwidth;
+	uint8_t *dest;
+	int page = 0;
+	int field;
 
 	if (!ofb->port->plane_info.enabled
 	 || ofb->port->update_window.x != src_x
 	 || ofb->port->update_window.y != src_y
 	 || ofb->port->update_window.width != src_w
 	 || ofb->port->update_window.height != src_h
-	 || ofb->port->update_window.format != xv_to_omapfb_format(image)
+	 || ofb->port->format != OMAPXVPlaneFormat(pScrn, image)
 	 || ofb->port->update_window.out_x != drw_x
 	 || ofb->port->update_window.out_y != drw_y
 	 || ofb->port->update_window.out_width != drw_w
 	 || ofb->port->update_window.out_height != drw_h)
 	{
 		int ret;
+
+		/* The queue pans the plane as it is now */
+		OMAPXVStopQueue(pScrn);
 		
 		/* Currently this is only used to track the plane state */
 		ofb->port->update_window.x = src_x;
@@ -163,27 +433,92 @@ int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
 			return Success;
 		}
 
+		/* Shrink in software what the scaler can't, or what would
+		 * take too much bandwidth to scan out
+		 */
+		field = ofb->port->field;
+		ofb->port->decimate = OMAPXVDecimation(pScrn, image,
+		                                       src_w & ~15,
+		                                       (src_h & ~15) >> (field != 0),
+		                                       drw_w & ~15, drw_h & ~15,
+		                                       &bandwidth);
+
+		/* A single field can be picked from interleaved lines, but
+		 * not from the planes of YUV420, which the plane scans out
+		 * when nothing is shrunk
+		 */
+		if (field && OMAPXVPlaneFormat(pScrn, image) == OMAPFB_COLOR_YUV420) {
+			field = 0;
+			ofb->port->decimate = OMAPXVDecimation(pScrn, image,
+			                                       src_w & ~15, src_h & ~15,
+			                                       drw_w & ~15, drw_h & ~15,
+			                                       &bandwidth);
+		}
+		ofb->port->shown_field = field;
+
+		/* Scanning out too much makes the display FIFOs underflow,
+		 * refuse the video rather than break the whole display
+		 */
+		if (!bw_fits(&ofb->bandwidth, OMAPFB_BW_VIDEO, bandwidth)) {
+			xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+			           "XV: %ix%i to %ix%i needs %lu MB/s, which is over the budget\n",
+			           src_w, src_h, drw_w, drw_h, bandwidth / 1000);
+			if (ofb->port->plane_info.enabled)
+				OMAPFBXVStopVideoGeneric(pScrn, NULL, FALSE);
+			return XvBadAlloc;
+		}
+
+		/* A bigger or deeper image doesn't fit the memory the
+		 * plane has, which can only be resized when it's off
+		 */
+		if (ofb->port->plane_info.enabled
+		 && ofb->port->mem_info.size > ofb->port->mapped_size)
+			OMAPFBXVStopVideoGeneric(pScrn, NULL, FALSE);
+
 		/* If we don't have the plane running, enable it */
 		if (!ofb->port->plane_info.enabled) {
 			ret = OMAPXVAllocPlane(pScrn);
+			if (ret != Success && ofb->port->pages > 1) {
+				xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+				           "XV: No memory for queueing frames, "
+				           "they are shown as they come\n");
+				ofb->port->mem_info.size /= ofb->port->pages;
+				ofb->port->pages = 1;
+				ret = OMAPXVAllocPlane(pScrn);
+			}
 			if (ret != Success)
-				return ret;
+				return OMAPXVSetupFailed(pScrn, ret);
 		}
 
 		/* Set up the state info, xres and yres will be used for
-		 * scaling to the values in the plane info struct
+		 * scaling to the values in the plane info struct. The pages
+		 * are stacked vertically, we start on the first.
 		 */
-		ofb->port->state_info.xres = src_w & ~15;
-		ofb->port->state_info.yres = src_h & ~15;
-		ofb->port->state_info.xres_virtual = 0;
-		ofb->port->state_info.yres_virtual = 0;
+		ofb->port->state_info.xres = OMAPXVDecimatedWidth(ofb->port, src_w);
+		ofb->port->state_info.yres = OMAPXVDecimatedHeight(ofb->port, src_h);
+		ofb->port->state_info.xres_virtual = ofb->port->state_info.xres;
 		ofb->port->state_info.xoffset = 0;
 		ofb->port->state_info.yoffset = 0;
+		/* For a single field the plane skips every other line of the
+		 * frame, and starts one line in for the bottom field. The
+		 * scaler interpolates the missing lines. Decimation already
+		 * picks out the field.
+		 */
+		if (field) {
+			ofb->port->state_info.yres /= 2;
+			if (ofb->port->decimate == 1) {
+				ofb->port->state_info.xres_virtual *= 2;
+				if (field == 2)
+					ofb->port->state_info.xoffset = ofb->port->state_info.xres;
+			}
+		}
+		ofb->port->state_info.yres_virtual =
+			ofb->port->state_info.yres * ofb->port->pages;
 		ofb->port->state_info.rotate = 0;
 		ofb->port->state_info.grayscale = 0;
 		ofb->port->state_info.activate = FB_ACTIVATE_NOW;
-		ofb->port->state_info.bits_per_pixel = 0;
-		ofb->port->state_info.nonstd = xv_to_omapfb_format(image);
+		ofb->port->format = OMAPXVPlaneFormat(pScrn, image);
+		OMAPXVSetPixelFormat(&ofb->port->state_info, ofb->port->format);
 
 		/* Set up the video plane info */
 		ofb->port->plane_info.enabled = 1;
@@ -204,8 +539,44 @@ int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
 
 		ret = OMAPXVSetupVideoPlane(pScrn);
 		if (ret != Success)
-			return ret;
+			return OMAPXVSetupFailed(pScrn, ret);
+
+		bw_set(&ofb->bandwidth, OMAPFB_BW_VIDEO, bandwidth);
+
+		ofb->port->page_height = ofb->port->state_info.yres;
+		ofb->port->page_size = ofb->port->state_info.xres_virtual
+		                       * ofb->port->page_height
+		                       * ofb->port->state_info.bits_per_pixel / 8;
+		ofb->port->front_page = 0;
+
+		/* Planar pages don't follow each other line by line, those
+		 * are written in place
+		 */
+		if (ofb->port->pages > 1
+		 && ofb->port->format != OMAPFB_COLOR_YUV420) {
+			ofb->port->queue = OMAPXVQueueCreate(ofb->port->fd,
+			                                     &ofb->port->state_info,
+			                                     ofb->port->page_height);
+			if (ofb->port->queue == NULL)
+				xf86DrvMsg(pScrn->scrnIndex, X_WARNING,
+				           "XV: No vsync, frames are shown as they come\n");
+		}
+	}
 
+	/* Convert into a page that is free, the queue shows it when it's
+	 * time
+	 */
+	if (ofb->port->queue != NULL)
+		page = OMAPXVQueueGetPage(ofb->port->queue);
+	dest = (uint8_t*)ofb->port->fb + page * ofb->port->page_size;
+
+	if (ofb->port->decimate > 1) {
+		int ret = OMAPXVPutDecimated(pScrn, src_w, src_h, image, buf,
+		                             dest, sync);
+		if (ofb->port->queue != NULL)
+			OMAPXVQueuePresent(ofb->port->queue, page);
+		OMAPXVUpdateVideoArea(pScrn);
+		return ret;
 	}
 
 	switch (image)
@@ -222,9 +593,49 @@ int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
 		{
 			packed_line_copy(src_w & ~15,
 			                 src_h & ~15,
+			                 2,
+			                 ((src_w + 1) & ~1) * 2,
+			                 (uint8_t*)buf,
+			                 dest);
+			break;
+		}
+
+		/* RGB goes to the plane as it is */
+		case FOURCC_RGB565:
+		{
+			packed_line_copy(src_w & ~15,
+			                 src_h & ~15,
+			                 2,
 			                 ((src_w + 1) & ~1) * 2,
 			                 (uint8_t*)buf,
-			                 (uint8_t*)ofb->port->fb);
+			                 dest);
+			break;
+		}
+		case FOURCC_XRGB8888:
+		{
+			packed_line_copy(src_w & ~15,
+			                 src_h & ~15,
+			                 4,
+			                 src_w * 4,
+			                 (uint8_t*)buf,
+			                 dest);
+			break;
+		}
+
+		/* NV12 has the U and V interleaved in a single half
+		 * resolution plane
+		 */
+		case FOURCC_NV12:
+		{
+			int src_pitch = (src_w + 3) & ~3;
+			uint8_t *yb = buf;
+			uint8_t *uvb = yb + (src_pitch * ((src_h + 1) & ~1));
+			nv12_to_uyvy(src_w & ~15,
+			             src_h & ~15,
+			             src_pitch,
+			             src_pitch,
+			             yb, uvb,
+			             dest);
 			break;
 		}
 
@@ -242,12 +653,21 @@ int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
 			uint8_t *yb = buf;
 			uint8_t *ub = yb + (src_y_pitch * src_h);
 			uint8_t *vb = ub + (src_uv_pitch * (src_h / 2));
+			if (ofb->port->format == OMAPFB_COLOR_YUV420) {
+				uv12_copy(src_w & ~15,
+				          src_h & ~15,
+				          src_y_pitch,
+				          src_uv_pitch,
+				          yb, ub, vb,
+				          dest);
+				break;
+			}
 			uv12_to_uyvy(src_w & ~15,
 			             src_h & ~15,
 			             src_y_pitch,
 			             src_uv_pitch,
 			             yb, ub, vb,
-			             (uint8_t*)ofb->port->fb);
+			             dest);
 			break;
 		}
 		case FOURCC_YV12:
@@ -258,18 +678,31 @@ int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
 			uint8_t *yb = buf;
 			uint8_t *vb = yb + (src_y_pitch * src_h);
 			uint8_t *ub = vb + (src_uv_pitch * (src_h / 2));
+			if (ofb->port->format == OMAPFB_COLOR_YUV420) {
+				uv12_copy(src_w & ~15,
+				          src_h & ~15,
+				          src_y_pitch,
+				          src_uv_pitch,
+				          yb, ub, vb,
+				          dest);
+				break;
+			}
 			uv12_to_uyvy(src_w & ~15,
 			             src_h & ~15,
 			             src_y_pitch,
 			             src_uv_pitch,
 			             yb, ub, vb,
-			             (uint8_t*)ofb->port->fb);
+			             dest);
 			break;
 		}
 		default:
 			break;
 	}
 
+	if (ofb->port->queue != NULL)
+		OMAPXVQueuePresent(ofb->port->queue, page);
+	OMAPXVUpdateVideoArea(pScrn);
+
 	if (sync) {
 		if (ioctl (ofb->port->fd, OMAPFB_SYNC_GFX))
 		{
@@ -291,6 +724,8 @@ void OMAPFBXVStopVideoGeneric (ScrnInfoPtr pScrn, pointer data, Bool cleanup)
 		return;
 
 	if(ofb->port->plane_info.enabled) {
+		OMAPXVStopQueue(pScrn);
+
 		if (ioctl (ofb->port->fd, OMAPFB_SYNC_GFX))
 		{
 			xf86Msg(X_ERROR, "%s: Graphics sync failed\n", __FUNCTION__);
@@ -303,12 +738,16 @@ void OMAPFBXVStopVideoGeneric (ScrnInfoPtr pScrn, pointer data, Bool cleanup)
 		}
 
 		/* Disable the video plane */
-		munmap(ofb->port->fb, ofb->port->mem_info.size);
+		munmap(ofb->port->fb, ofb->port->mapped_size);
+		ofb->port->fb = NULL;
+		ofb->port->mapped_size = 0;
 		ofb->port->plane_info.enabled = 0;
 		if (ioctl (ofb->port->fd, OMAPFB_SETUP_PLANE, &ofb->port->plane_info)) {
 	    		xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
 	    		           "Failed to disable video plane\n");
 		}
+		bw_set(&ofb->bandwidth, OMAPFB_BW_VIDEO, 0);
+		OMAPXVUpdateVideoArea(pScrn);
 		if (ioctl (ofb->port->fd, OMAPFB_QUERY_PLANE, &ofb->port->plane_info)) {
     			xf86DrvMsg(pScrn->scrnIndex, X_ERROR,
     			           "Failed to query video plane info\n");
@@ -32,9 +32,20 @@
 
 #include "omapfb-driver.h"
 
+/* Formats fourcc.h doesn't know about, with the DRM fourccs */
+#define FOURCC_RGB565 0x36314752 /* RG16 */
+#define FOURCC_XRGB8888 0x34325258 /* XR24 */
+#define FOURCC_NV12 0x3231564e
+
+/* Pitches and offsets of the image planes, returns the image size */
+int OMAPXVImageLayout (int id, unsigned short *width, unsigned short *height,
+                       int *pitches, int *offsets);
+
 enum omapfb_color_format xv_to_omapfb_format(int format);
 int OMAPXVAllocPlane(ScrnInfoPtr pScrn);
 int OMAPXVSetupVideoPlane(ScrnInfoPtr pScrn);
+/* Forgets the plane setup so the next frame does it again, returns ret */
+int OMAPXVSetupFailed(ScrnInfoPtr pScrn, int ret);
 
 int OMAPFBXVPutImageGeneric (ScrnInfoPtr pScrn,
                              short src_x, short src_y, short drw_x, short drw_y,
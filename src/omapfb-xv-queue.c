@@ -0,0 +1,207 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "omapfb.h"
+#include "omapfb-xv-queue.h"
+
+/* Refreshes without a new frame longer than this mean the video is
+ * paused rather than running slower than the display
+ */
+#define OMAPXV_QUEUE_MAX_REPEAT 8
+
+struct _OMAPXVQueue {
+	int fd;
+	struct fb_var_screeninfo var;
+	int page_height;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	int quit;
+
+	/* Page on the screen, the one that was until the pan to it takes
+	 * effect, and the newest frame not shown yet. -1 for none.
+	 */
+	int front;
+	int retiring;
+	int queued;
+
+	/* Refreshes since the last new frame */
+	int idle;
+	struct omapxv_queue_stats stats;
+};
+
+static void *
+OMAPXVQueueThread(void *data)
+{
+	OMAPXVQueuePtr q = data;
+
+	for (;;) {
+		int ret = ioctl(q->fd, OMAPFB_VSYNC);
+
+		pthread_mutex_lock(&q->lock);
+
+		if (q->quit) {
+			pthread_mutex_unlock(&q->lock);
+			break;
+		}
+
+		/* The display can be off, don't spin while it is */
+		if (ret != 0) {
+			pthread_mutex_unlock(&q->lock);
+			usleep(20000);
+			continue;
+		}
+
+		/* The last pan is in effect now */
+		q->retiring = -1;
+
+		if (q->queued >= 0) {
+			struct fb_var_screeninfo v = q->var;
+
+			v.yoffset = q->var.yoffset + q->queued * q->page_height;
+			if (ioctl(q->fd, FBIOPAN_DISPLAY, &v) == 0) {
+				q->retiring = q->front;
+				q->front = q->queued;
+				q->stats.shown++;
+				if (q->idle <= OMAPXV_QUEUE_MAX_REPEAT)
+					q->stats.repeated += q->idle;
+			} else {
+				q->stats.dropped++;
+			}
+			q->queued = -1;
+			q->idle = 0;
+		} else {
+			q->idle++;
+		}
+
+		pthread_mutex_unlock(&q->lock);
+	}
+
+	return NULL;
+}
+
+OMAPXVQueuePtr
+OMAPXVQueueCreate(int fd, const struct fb_var_screeninfo *var, int page_height)
+{
+	OMAPXVQueuePtr q;
+	sigset_t all, old;
+	int ret;
+
+	/* Without vsync there's nothing to pace with */
+	if (ioctl(fd, OMAPFB_VSYNC) != 0)
+		return NULL;
+
+	q = calloc(1, sizeof(*q));
+	if (q == NULL)
+		return NULL;
+
+	q->fd = fd;
+	q->var = *var;
+	q->page_height = page_height;
+	q->front = 0;
+	q->retiring = -1;
+	q->queued = -1;
+	/* Nothing is playing yet */
+	q->idle = OMAPXV_QUEUE_MAX_REPEAT + 1;
+
+	pthread_mutex_init(&q->lock, NULL);
+
+	/* The server runs input and the cursor from its signal handlers,
+	 * and only blocks those in its own thread. The thread inherits
+	 * our mask, so have it block everything.
+	 */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	ret = pthread_create(&q->thread, NULL, OMAPXVQueueThread, q);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (ret != 0) {
+		pthread_mutex_destroy(&q->lock);
+		free(q);
+		return NULL;
+	}
+
+	return q;
+}
+
+int
+OMAPXVQueueGetPage(OMAPXVQueuePtr q)
+{
+	int page;
+
+	pthread_mutex_lock(&q->lock);
+
+	for (page = 0; page < OMAPXV_QUEUE_PAGES; page++) {
+		if (page != q->front && page != q->retiring && page != q->queued)
+			break;
+	}
+
+	/* The previous frame hasn't been shown yet and never will be */
+	if (page == OMAPXV_QUEUE_PAGES) {
+		page = q->queued;
+		q->queued = -1;
+		q->stats.dropped++;
+	}
+
+	pthread_mutex_unlock(&q->lock);
+
+	return page;
+}
+
+void
+OMAPXVQueuePresent(OMAPXVQueuePtr q, int page)
+{
+	pthread_mutex_lock(&q->lock);
+
+	if (q->queued >= 0 && q->queued != page)
+		q->stats.dropped++;
+	q->queued = page;
+
+	pthread_mutex_unlock(&q->lock);
+}
+
+void
+OMAPXVQueueDestroy(OMAPXVQueuePtr q, struct omapxv_queue_stats *stats)
+{
+	pthread_mutex_lock(&q->lock);
+	q->quit = 1;
+	pthread_mutex_unlock(&q->lock);
+
+	/* Waits for at most one refresh */
+	pthread_join(q->thread, NULL);
+	pthread_mutex_destroy(&q->lock);
+
+	if (stats != NULL)
+		*stats = q->stats;
+
+	free(q);
+}
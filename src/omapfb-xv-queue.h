@@ -0,0 +1,71 @@
+/* Texas Instruments OMAP framebuffer driver for X.Org
+ * Copyright 2010 Kalle Vahlman, <kalle.vahlman@movial.com>
+ *
+ * Permission to use, copy, modify, distribute and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the names of the authors and/or copyright holders
+ * not be used in advertising or publicity pertaining to distribution of the
+ * software without specific, written prior permission.  The authors and
+ * copyright holders make no representations about the suitability of this
+ * software for any purpose.  It is provided "as is" without any express
+ * or implied warranty.
+ *
+ * THE AUTHORS AND COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO
+ * THIS SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Presentation queue for the video plane. Frames are converted into one
+ * of OMAPXV_QUEUE_PAGES pages stacked vertically in the plane memory and
+ * queued, and a thread waiting for vsync pans the plane to the newest
+ * queued page once per refresh. A frame that is replaced before it got
+ * shown is dropped, so the display sets the pace and not the client.
+ *
+ * This is plain C without X server dependencies, the thread must not
+ * call into the server.
+ */
+
+#ifndef __OMAPFB_XV_QUEUE_H__
+#define __OMAPFB_XV_QUEUE_H__
+
+#include <linux/fb.h>
+
+#define OMAPXV_QUEUE_PAGES 3
+
+struct omapxv_queue_stats {
+	/* Frames that made it to the display */
+	unsigned long shown;
+	/* Refreshes that showed the previous frame again while playing */
+	unsigned long repeated;
+	/* Frames replaced by a newer one before they got shown */
+	unsigned long dropped;
+};
+
+typedef struct _OMAPXVQueue *OMAPXVQueuePtr;
+
+/* Starts pacing the plane of fd, set up as var with pages of page_height
+ * lines. Page 0 is taken to be on the screen. Returns NULL if the plane
+ * can't tell us about vsync.
+ */
+OMAPXVQueuePtr OMAPXVQueueCreate(int fd, const struct fb_var_screeninfo *var,
+                                 int page_height);
+
+/* Page that can be written to. If all of them are busy, the queued frame
+ * is taken back and counted as dropped.
+ */
+int OMAPXVQueueGetPage(OMAPXVQueuePtr q);
+
+/* Queues a page from OMAPXVQueueGetPage to be shown at the next vsync */
+void OMAPXVQueuePresent(OMAPXVQueuePtr q, int page);
+
+/* Stops the thread, the plane stays on the page last shown */
+void OMAPXVQueueDestroy(OMAPXVQueuePtr q, struct omapxv_queue_stats *stats);
+
+#endif /* __OMAPFB_XV_QUEUE_H__ */
@@ -54,18 +54,90 @@ static XF86VideoFormatRec xv_formats[OMAPFB_XV_FORMAT_COUNT] = {
     { 24, TrueColor },
 };
 
+#define XVIMAGE_RGB565 \
+   { \
+	FOURCC_RGB565, \
+	XvRGB, \
+	LSBFirst, \
+	{'R','G','1','6', \
+	  0x00,0x00,0x00,0x10,0x80,0x00,0x00,0xAA,0x00,0x38,0x9B,0x71}, \
+	16, \
+	XvPacked, \
+	1, \
+	16, 0xf800, 0x07e0, 0x001f, \
+	0, 0, 0, \
+	0, 0, 0, \
+	0, 0, 0, \
+	{'R','G','B',0, \
+	  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, \
+	XvTopToBottom \
+   }
+
+#define XVIMAGE_XRGB8888 \
+   { \
+	FOURCC_XRGB8888, \
+	XvRGB, \
+	LSBFirst, \
+	{'X','R','2','4', \
+	  0x00,0x00,0x00,0x10,0x80,0x00,0x00,0xAA,0x00,0x38,0x9B,0x71}, \
+	32, \
+	XvPacked, \
+	1, \
+	24, 0xff0000, 0x00ff00, 0x0000ff, \
+	0, 0, 0, \
+	0, 0, 0, \
+	0, 0, 0, \
+	{'R','G','B',0, \
+	  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, \
+	XvTopToBottom \
+   }
+
+#define XVIMAGE_NV12 \
+   { \
+	FOURCC_NV12, \
+	XvYUV, \
+	LSBFirst, \
+	{'N','V','1','2', \
+	  0x00,0x00,0x00,0x10,0x80,0x00,0x00,0xAA,0x00,0x38,0x9B,0x71}, \
+	12, \
+	XvPlanar, \
+	2, \
+	0, 0, 0, 0, \
+	8, 8, 8, \
+	1, 2, 2, \
+	1, 2, 2, \
+	{'Y','U','V',0, \
+	  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, \
+	XvTopToBottom \
+   }
+
+/* The Blizzard path only handles the first OMAPFB_XV_BLIZZARD_IMAGES */
+#define OMAPFB_XV_BLIZZARD_IMAGES 4
 static XF86ImageRec xv_images[] = {
     XVIMAGE_YUY2, /* OMAPFB_COLOR_YUY422 */
     XVIMAGE_UYVY, /* OMAPFB_COLOR_YUV422 */
     XVIMAGE_I420, /* OMAPFB_COLOR_YUV420 */
     XVIMAGE_YV12, /* OMAPFB_COLOR_YUV420 */
+    XVIMAGE_RGB565, /* OMAPFB_COLOR_RGB565 */
+    XVIMAGE_XRGB8888, /* OMAPFB_COLOR_RGB24U */
+    XVIMAGE_NV12, /* OMAPFB_COLOR_YUV422 */
 };
 
-/* TODO: */
 static XF86AttributeRec xv_attributes[] = {
     { XvSettable | XvGettable, 0, 0xffff, "XV_COLORKEY" },
+    { XvSettable | XvGettable, 0, 2, "XV_FIELD" },
 };
 
+/* XV_PIXEL_DOUBLE is only there when the controller can do it */
+static XF86AttributeRec xv_blizzard_attributes[] = {
+    { XvSettable | XvGettable, 0, 0xffff, "XV_COLORKEY" },
+    { XvSettable | XvGettable, 0, 1, "XV_PIXEL_DOUBLE" },
+};
+
+static Atom xvColorKey, xvPixelDouble, xvField;
+
+#define MAKE_ATOM(a) MakeAtom(a, sizeof(a) - 1, TRUE)
+
 /* Port */
 
 static Bool OMAPFBPortGetRec(ScrnInfoPtr pScrn);
@@ -73,13 +145,54 @@ static void OMAPFBPortFreeRec(ScrnInfoPtr pScrn);
 
 /* XV interface functions */
 
+/* Is the attribute one the adaptor lists? */
+static Bool OMAPFBXVHasAttribute (OMAPFBPtr ofb, Atom attribute)
+{
+	int i;
+
+	for (i = 0; i < ofb->port->n_attributes; i++) {
+		char *name = ofb->port->attributes[i].name;
+		if (attribute == MakeAtom(name, strlen(name), FALSE))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
 /* Set attributes */
 static int OMAPFBXVSetPortAttribute (ScrnInfoPtr pScrn,
                                      Atom attribute,
                                      INT32 value,
                                      pointer data)
 {
+	OMAPFBPtr ofb = OMAPFB(pScrn);
 	xf86DrvMsg(pScrn->scrnIndex, X_INFO, "XV: %s\n", __FUNCTION__);
+
+	if (!OMAPFBXVHasAttribute(ofb, attribute))
+		return BadMatch;
+
+	if (attribute == xvColorKey) {
+		ofb->port->colorkey = value;
+	} else if (attribute == xvPixelDouble) {
+		if (value < 0 || value > 1)
+			return BadValue;
+		if (ofb->port->pixel_double != value) {
+			ofb->port->pixel_double = value;
+			/* Set the plane up again on the next frame */
+			ofb->port->update_window.out_width = 0;
+		}
+	} else if (attribute == xvField) {
+		if (value < 0 || value > 2)
+			return BadValue;
+		if (ofb->port->field != value) {
+			ofb->port->field = value;
+			/* Set the plane up again on the next frame */
+			ofb->port->update_window.out_width = 0;
+		}
+	} else {
+		return BadMatch;
+	}
+
 	return Success;
 }
 
@@ -89,10 +202,24 @@ static int OMAPFBXVGetPortAttribute (ScrnInfoPtr pScrn,
                                      INT32 *value,
                                      pointer data)
 {
+	OMAPFBPtr ofb = OMAPFB(pScrn);
 	xf86DrvMsg(pScrn->scrnIndex, X_INFO, "XV: %s\n", __FUNCTION__);
 
-	if (value != NULL)
-		*value = 1;
+	if (!OMAPFBXVHasAttribute(ofb, attribute))
+		return BadMatch;
+
+	if (value == NULL)
+		return Success;
+
+	if (attribute == xvColorKey)
+		*value = ofb->port->colorkey;
+	else if (attribute == xvPixelDouble)
+		*value = ofb->port->pixel_double;
+	else if (attribute == xvField)
+		*value = ofb->port->field;
+	else
+		return BadMatch;
+
 	return Success;
 }
 
@@ -117,14 +244,12 @@ static void OMAPFBXVQueryBestSize (ScrnInfoPtr pScrn,
 }
 
 /* Calculates and returns image size for different formats */
-static int OMAPFBXVQueryImageAttributes (ScrnInfoPtr pScrn,
-                                         int id, unsigned short *width, unsigned short *height,
-                                         int *pitches, int *offsets)
+int OMAPXVImageLayout (int id, unsigned short *width, unsigned short *height,
+                       int *pitches, int *offsets)
 {
 	int w, h;
 	int size = 0;
 	int tmp = 0;
-	OMAPFBPtr ofb = OMAPFB(pScrn);
 
 	w = *width;
 	h = *height;
@@ -154,6 +279,24 @@ static int OMAPFBXVQueryImageAttributes (ScrnInfoPtr pScrn,
 				offsets[2] = size;
 				size += tmp;
 			break;
+		case FOURCC_NV12:
+			w = (w + 3) & ~3;
+			h = (h + 1) & ~1;
+			size = w;
+			if (pitches)
+				pitches[0] = pitches[1] = size;
+			size *= h;
+			if (offsets)
+				offsets[1] = size;
+			size += w * (h >> 1);
+			break;
+		case FOURCC_XRGB8888:
+			size = w << 2;
+			if (pitches)
+				pitches[0] = size;
+			size *= h;
+			break;
+		case FOURCC_RGB565:
 		case FOURCC_UYVY:
 		case FOURCC_YUY2:
 		default:
@@ -165,12 +308,25 @@ static int OMAPFBXVQueryImageAttributes (ScrnInfoPtr pScrn,
 			break;
 	}
 
-	w = *width;
-	h = *height;
+	return size;
+}
 
+/* The image size, and the plane memory needed for showing the image */
+static int OMAPFBXVQueryImageAttributes (ScrnInfoPtr pScrn,
+                                         int id, unsigned short *width, unsigned short *height,
+                                         int *pitches, int *offsets)
+{
+	OMAPFBPtr ofb = OMAPFB(pScrn);
+	int size = OMAPXVImageLayout(id, width, height, pitches, offsets);
+	int w = *width;
+	int h = *height;
+
+	/* Everything but XRGB8888 goes to the plane with 2 bytes per pixel
+	 * or less
+	 */
 	w = (w + 1) & ~1;
-	ofb->port->mem_info.size = w << 1;
-	ofb->port->mem_info.size *= h;
+	ofb->port->mem_info.size = w << (id == FOURCC_XRGB8888 ? 2 : 1);
+	ofb->port->mem_info.size *= h * ofb->port->pages;
 
 	return size;
 }
@@ -253,7 +409,16 @@ int OMAPFBXVInit (ScrnInfoPtr pScrn,
 	}
 
 	OMAPFBPrintCapabilities(pScrn, &caps, "Video plane");
+	ofb->port->caps = caps;
 
+	/* Planar YUV can go to the plane as it is, except on Blizzard
+	 * which has its own idea of the YUV420 layout
+	 */
+	ofb->port->planar = (caps.plane_color & (1 << OMAPFB_COLOR_YUV420))
+	                 && strncmp(ofb->ctrl_name, "blizzard", 8) != 0;
+	if (ofb->port->planar)
+		xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+		           "XV: Planar YUV is shown without conversion\n");
 }
 
 	adaptor = xf86XVAllocateVideoAdaptorRec(pScrn);
@@ -263,6 +428,10 @@ int OMAPFBXVInit (ScrnInfoPtr pScrn,
 		return 0;
 	}
 
+	xvColorKey = MAKE_ATOM("XV_COLORKEY");
+	xvPixelDouble = MAKE_ATOM("XV_PIXEL_DOUBLE");
+	xvField = MAKE_ATOM("XV_FIELD");
+
 	xv_encodings[0].width = ofb->state_info.xres;
 	xv_encodings[0].height = ofb->state_info.yres;
 
@@ -276,9 +445,9 @@ int OMAPFBXVInit (ScrnInfoPtr pScrn,
 	adaptor->nPorts = 1;
 	/* Place per-port data here */
 	adaptor->pPortPrivates = (DevUnion *)(&adaptor[1]);
-	adaptor->nAttributes = 1;
+	adaptor->nAttributes = 2;
 	adaptor->pAttributes = xv_attributes;
-	adaptor->nImages = 4;
+	adaptor->nImages = sizeof(xv_images) / sizeof(xv_images[0]);
 	adaptor->pImages = xv_images;
 	adaptor->SetPortAttribute = OMAPFBXVSetPortAttribute;
 	adaptor->GetPortAttribute = OMAPFBXVGetPortAttribute;
@@ -289,6 +458,13 @@ int OMAPFBXVInit (ScrnInfoPtr pScrn,
 	adaptor->PutImage = OMAPFBXVPutImageGeneric;
 	adaptor->StopVideo = OMAPFBXVStopVideoGeneric;
 
+	/* Frames wait in a queue for the next refresh. Manual update
+	 * displays show a frame when it is sent, there's no refresh to
+	 * pace against.
+	 */
+	if (ofb->frame_pacing && !ofb->manual_update)
+		ofb->port->pages = OMAPXV_QUEUE_PAGES;
+
 	/* Allow customized functionality for different CPU revisions
 	 * and LCD controller chips
 	 */
@@ -296,7 +472,45 @@ int OMAPFBXVInit (ScrnInfoPtr pScrn,
 		/* Blizzard is Epson S1D13745A01, found on eg. Nokia N8x0 */
 		adaptor->PutImage = OMAPFBXVPutImageBlizzard;
 		adaptor->StopVideo = OMAPFBXVStopVideoBlizzard;
+		adaptor->nImages = OMAPFB_XV_BLIZZARD_IMAGES;
+		/* Fields aren't supported here */
+		adaptor->nAttributes = 1;
+		adaptor->pAttributes = xv_blizzard_attributes;
+
+		/* Updates go over a slow bus, so convert the next frame
+		 * while the previous one is still being sent
+		 */
+		ofb->port->pages = 2;
+
+		/* Time the updates against the panel refresh if we can */
+		ofb->port->tearsync = ofb->tear_sync
+		                   && (ofb->caps.ctrl & OMAPFB_CAPS_TEARSYNC);
+		ofb->port->tearsync_active = ofb->port->tearsync;
+		if (ofb->port->tearsync)
+			xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+			           "XV: Video updates are tear synced\n");
+
+		/* Video shown at twice the size or more can be sent at half
+		 * the size and doubled by the controller
+		 */
+		if (ofb->caps.ctrl & OMAPFB_CAPS_WINDOW_PIXEL_DOUBLE) {
+			adaptor->nAttributes = 2;
+			ofb->port->pixel_double = ofb->pixel_double;
+		}
+
+		/* It has a YUV420 format of its own, which saves a quarter
+		 * of the bus traffic compared to UYVY
+		 */
+		ofb->port->planar = ofb->blizzard_yuv420
+		                 && (ofb->port->caps.plane_color
+		                     & (1 << OMAPFB_COLOR_YUV420));
+		if (ofb->port->planar)
+			xf86DrvMsg(pScrn->scrnIndex, X_INFO,
+			           "XV: Using the Blizzard YUV420 format\n");
 	}
+
+	ofb->port->attributes = adaptor->pAttributes;
+	ofb->port->n_attributes = adaptor->nAttributes;
 	
 	n_adaptors++;
 	
@@ -315,6 +529,7 @@ OMAPFBPortGetRec(ScrnInfoPtr pScrn)
 		return TRUE;
 	
 	ofb->port = xnfcalloc(sizeof(OMAPFBPortRec), 1);
+	ofb->port->pages = 1;
 	memset(&ofb->port->update_window, 0, sizeof(struct omapfb_update_window));
 	REGION_EMPTY(pScrn, &ofb->port->current_clip);
 